@@ -2,43 +2,555 @@
 
 /*
  * 日志工具
- * 
+ *
  * 创建于 2023年12月26日 上海市嘉定区安亭镇
  */
 
 #include "Log.h"
 
+#include <atomic>
+#include <cerrno>
 #include <ctime>
+#include <thread>
+
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 using namespace std;
-    
+
 namespace vl {
 namespace log {
 
-inline static void printLineInfo(const char* filename, int line) {
-    clog << "[" 
-        << filename 
-        << " " 
-        << line 
-        << "]";
-}
+/*
+ * 环形缓冲采用 Vyukov 的有界 MPMC 队列：每个槽位带一个序号，
+ * 生产者用 CAS 抢占写入位置，写完后发布序号；唯一的消费者是后台写出线程。
+ */
+
+static const size_t SLOT_COUNT = 512;
+
+/** 颜色、时间、正文、颜色复位与换行。JSON 格式下正文过长时被截断。 */
+static const size_t SLOT_DATA = 21 + 21 + 1 + MAX_LINE + 4 + 1;
+
+/** 单次 writev 最多写出的行数。 */
+static const int MAX_BATCH = 64;
+
+struct alignas(64) Slot {
+    atomic<uint64_t> seq;
+    uint32_t len;
+    char data[SLOT_DATA];
+};
+
+static_assert(sizeof(Slot) == 512);
+static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0);
+
+static Slot slots[SLOT_COUNT];
+
+/** 下一个写入位置。 */
+alignas(64) static atomic<uint64_t> tail { 0 };
+
+/** 下一个读出位置。只有写出线程访问。 */
+alignas(64) static uint64_t head = 0;
+
+/** 缓冲写满而丢弃的行数。 */
+static atomic<uint64_t> dropped { 0 };
+
+static atomic<bool> async { false };
+static atomic<bool> stopping { false };
+
+/** 写出线程是否即将休眠。生产者据此决定是否唤醒。 */
+static atomic<bool> sleeping { false };
+static atomic<uint32_t> wakeups { 0 };
+
+static thread writer;
+
+int runtimeLevel = VL_LOG_MIN_LEVEL;
+static Format format = Format::TEXT;
 
-inline static void printCurrentTime() {
+static const char* LEVEL_NAMES[] = { "debug", "info", "warn", "error", "off" };
+
+
+/**
+ * 一条待格式化的日志。
+ */
+struct Record {
+    int level;
+    const char* color;
+    const char* file;
+    int line;
+    const char* text;
+    size_t len;
+
+    /** 键值对。偏移相对于 text。 */
+    const Field* fields = nullptr;
+    size_t fieldCount = 0;
+};
+
+
+/**
+ * 向定长缓冲追加内容。空间不足时截断。
+ */
+struct Writer {
+    char* p;
+    char* end;
+
+    void put(const char* s, size_t n) {
+        n = min(n, size_t(end - p));
+        memcpy(p, s, n);
+        p += n;
+    }
+
+    void put(string_view s) {
+        put(s.data(), s.size());
+    }
+
+    void put(char c) {
+        if (p < end) {
+            *p++ = c;
+        }
+    }
+
+    /**
+     * 空间不足时在完整的 UTF-8 字符处截断。
+     */
+    void putChars(const char* s, size_t n) {
+        if (n > size_t(end - p)) {
+            n = end - p;
+            while (n > 0 && (s[n] & 0xc0) == 0x80) {
+                n--;
+            }
+        }
+        put(s, n);
+    }
+};
+
+
+/**
+ * 格式化当前时间。每个线程每秒只格式化一次。
+ *
+ * @param iso8601 为 false 时格式为 "[%Y-%m-%d %H:%M:%S]"，否则为 "%Y-%m-%dT%H:%M:%S%z"。
+ */
+static string_view formatTime(bool iso8601) {
+    struct Cache {
+        time_t sec = -1;
+        char str[32];
+        size_t len = 0;
+    };
+    thread_local Cache caches[2];
+
+    auto& cache = caches[iso8601];
     time_t now = time(nullptr);
-    tm* currTm = localtime(&now);
-    char timeStr[32] = "";
-    strftime(
-        timeStr, 
-        sizeof(timeStr) / sizeof(char), 
-        "[%Y-%m-%d %H:%M:%S]", 
-        currTm
-    );
-    clog << timeStr;
-}
-
-void printInfo(const char* filename, int line) {
-    printCurrentTime();
-    clog << " ";
+    if (now != cache.sec) {
+        tm currTm;
+        localtime_r(&now, &currTm);
+        const char* pattern = iso8601 ? "%Y-%m-%dT%H:%M:%S%z" : "[%Y-%m-%d %H:%M:%S]";
+        cache.len = strftime(cache.str, sizeof(cache.str), pattern, &currTm);
+        cache.sec = now;
+    }
+
+    return string_view(cache.str, cache.len);
+}
+
+
+static void formatText(Writer& out, const Record& rec) {
+    bool colored = rec.color && !ConsoleColorPad::noColor;
+
+    if (colored) {
+        out.put(rec.color);
+    }
+
+    out.put(formatTime(false));
+    out.put(' ');
+
+    // 为颜色复位留出空间。
+    out.end -= 4;
+    out.putChars(rec.text, min(rec.len, MAX_LINE));
+    for (size_t i = 0; i < rec.fieldCount; i++) {
+        auto& field = rec.fields[i];
+        out.put(' ');
+        out.putChars(rec.text + field.key, field.keyLen);
+        out.put('=');
+        out.putChars(rec.text + field.value, field.valueLen);
+    }
+    out.end += 4;
+
+    if (colored) {
+        out.put("\e[0m");
+    }
+}
+
+
+/**
+ * 按 JSON 字符串的规则转义。空间不足时在完整的字符处截断。
+ *
+ * @return 全部写入时返回 true。
+ */
+static bool putEscaped(Writer& out, const char* s, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+
+    // 当前 UTF-8 字符在 out 中的起点。
+    char* charStart = out.p;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = s[i];
+        char buf[6];
+        size_t n = 0;
+
+        if ((c & 0xc0) != 0x80) {
+            charStart = out.p;
+        }
+
+        if (c == '"' || c == '\\') {
+            buf[n++] = '\\';
+            buf[n++] = c;
+        } else if (c == '\n') {
+            buf[n++] = '\\';
+            buf[n++] = 'n';
+        } else if (c == '\t') {
+            buf[n++] = '\\';
+            buf[n++] = 't';
+        } else if (c < 0x20 || c == 0x7f) {
+            memcpy(buf, "\\u00", 4);
+            n = 4;
+            buf[n++] = hex[c >> 4];
+            buf[n++] = hex[c & 0xf];
+        } else {
+            buf[n++] = c;
+        }
+
+        if (size_t(out.end - out.p) < n) {
+            // 截在多字节字符中间会产生非法的 UTF-8，整个字符都不写。
+            if ((c & 0xc0) == 0x80) {
+                out.p = charStart;
+            }
+            return false;
+        }
+        out.put(buf, n);
+    }
+
+    return true;
+}
+
+
+/**
+ * 输出 "fields" 对象。放不下的键值对整个丢弃，保证输出仍是合法的 JSON。
+ */
+static void putFields(Writer& out, const Record& rec) {
+    out.put(",\"fields\":{");
+
+    // 为 `},"msg":""}` 留出空间。
+    const size_t tail = 12;
+    out.end -= tail;
+
+    bool first = true;
+    for (size_t i = 0; i < rec.fieldCount; i++) {
+        auto& field = rec.fields[i];
+        char* start = out.p;
+
+        if (!first) {
+            out.put(',');
+        }
+        out.put('"');
+        bool done = putEscaped(out, rec.text + field.key, field.keyLen);
+        out.put(field.number ? "\":" : "\":\"");
+        done = done && putEscaped(out, rec.text + field.value, field.valueLen);
+        if (!field.number) {
+            out.put('"');
+        }
+
+        if (!done || out.p >= out.end) {
+            out.p = start;
+            continue;
+        }
+        first = false;
+    }
+
+    out.end += tail;
+    out.put('}');
+}
+
+
+static void formatJson(Writer& out, const Record& rec) {
+    char num[16];
+
+    out.put("{\"time\":\"");
+    out.put(formatTime(true));
+    out.put("\",\"level\":\"");
+    out.put(LEVEL_NAMES[rec.level]);
+    out.put("\",\"file\":\"");
+    putEscaped(out, rec.file, strlen(rec.file));
+    out.put("\",\"line\":");
+    out.put(num, to_chars(num, num + sizeof(num), rec.line).ptr - num);
+
+    if (rec.fieldCount > 0) {
+        putFields(out, rec);
+    }
+
+    out.put(",\"msg\":\"");
+
+    // 正文过长时截断，但要为结尾留出空间。
+    out.end -= 2;
+    putEscaped(out, rec.text, rec.len);
+    out.end += 2;
+
+    out.put("\"}");
+}
+
+
+/**
+ * 拼出完整的一行。out 至少有 SLOT_DATA 字节。
+ *
+ * @return 行的长度。
+ */
+static size_t formatLine(char* out, const Record& rec) {
+    // 末尾留给换行。
+    Writer writer = { out, out + SLOT_DATA - 1 };
+
+    if (format == Format::JSON) {
+        formatJson(writer, rec);
+    } else {
+        formatText(writer, rec);
+    }
+
+    *writer.p++ = '\n';
+    return writer.p - out;
+}
+
+
+/**
+ * 把 iov 全部写入 stderr。stderr 为非阻塞时等待其可写。
+ */
+static void writeAll(iovec* iov, int iovCount) {
+    while (iovCount > 0) {
+        ssize_t n = writev(STDERR_FILENO, iov, iovCount);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN) {
+                pollfd pfd = { STDERR_FILENO, POLLOUT, 0 };
+                poll(&pfd, 1, -1);
+                continue;
+            }
+            return;  // stderr 不可用时，没有别处可以报告。
+        }
+
+        while (iovCount > 0 && size_t(n) >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovCount--;
+        }
+
+        if (iovCount > 0) {
+            iov->iov_base = (char*) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+
+static void writeSync(const Record& rec) {
+    char buf[SLOT_DATA];
+    iovec iov = { buf, formatLine(buf, rec) };
+    writeAll(&iov, 1);
+}
+
+
+static bool slotReady(uint64_t pos) {
+    return slots[pos & (SLOT_COUNT - 1)].seq.load(memory_order_acquire) == pos + 1;
+}
+
+
+/**
+ * 写出当前可读的一批日志。
+ *
+ * @return 写出的行数。
+ */
+static int drainBatch() {
+    iovec iov[MAX_BATCH + 1];
+    int count = 0;
+
+    while (count < MAX_BATCH && slotReady(head + count)) {
+        auto& slot = slots[(head + count) & (SLOT_COUNT - 1)];
+        iov[count].iov_base = slot.data;
+        iov[count].iov_len = slot.len;
+        count++;
+    }
+
+    char note[SLOT_DATA];
+    uint64_t lost = dropped.exchange(0, memory_order_relaxed);
+    int iovCount = count;
+    if (lost) {
+        char text[64];
+        auto res = to_chars(text, text + sizeof(text), lost);
+        const char suffix[] = " log lines dropped: buffer full.";
+        memcpy(res.ptr, suffix, sizeof(suffix) - 1);
+        size_t len = res.ptr - text + sizeof(suffix) - 1;
+
+        iov[iovCount].iov_base = note;
+        Record rec = { LEVEL_WARN, COLOR_WARN, __FILE_NAME__, __LINE__, text, len };
+        iov[iovCount].iov_len = formatLine(note, rec);
+        iovCount++;
+    }
+
+    if (iovCount == 0) {
+        return 0;
+    }
+
+    writeAll(iov, iovCount);
+
+    // 归还槽位：序号前进一圈，生产者看到后即可再次写入。
+    for (int i = 0; i < count; i++) {
+        slots[(head + i) & (SLOT_COUNT - 1)].seq.store(head + i + SLOT_COUNT, memory_order_release);
+    }
+    head += count;
+
+    return count;
+}
+
+
+static void writerMain() {
+    while (true) {
+        if (drainBatch() > 0) {
+            continue;
+        }
+
+        if (stopping.load(memory_order_acquire)) {
+            return;
+        }
+
+        uint32_t seen = wakeups.load(memory_order_relaxed);
+        sleeping.store(true, memory_order_relaxed);
+
+        // 与 submit() 中的栅栏配对：要么这里看到新日志，要么生产者看到 sleeping。
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (!slotReady(head) && !stopping.load(memory_order_relaxed)) {
+            wakeups.wait(seen, memory_order_relaxed);
+        }
+
+        sleeping.store(false, memory_order_relaxed);
+    }
+}
+
+
+static void wakeWriter() {
+    wakeups.fetch_add(1, memory_order_relaxed);
+    wakeups.notify_one();
+}
+
+
+void submit(
+    int level, const char* color, const char* file, int line, const char* text, size_t len,
+    const Field* fields, size_t fieldCount
+) {
+    Record rec = { level, color, file, line, text, len, fields, fieldCount };
+
+    if (!async.load(memory_order_relaxed)) {
+        writeSync(rec);
+        return;
+    }
+
+    uint64_t pos = tail.load(memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots[pos & (SLOT_COUNT - 1)];
+        uint64_t seq = slot->seq.load(memory_order_acquire);
+        int64_t diff = int64_t(seq) - int64_t(pos);
+
+        if (diff == 0) {
+            if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 写满了。宁可丢日志，也不能让调用者等待。
+            dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        } else {
+            pos = tail.load(memory_order_relaxed);
+        }
+    }
+
+    slot->len = uint32_t(formatLine(slot->data, rec));
+    slot->seq.store(pos + 1, memory_order_release);
+
+    atomic_thread_fence(memory_order_seq_cst);
+    if (sleeping.load(memory_order_relaxed)) {
+        wakeWriter();
+    }
+}
+
+
+void setLevel(int level) {
+    runtimeLevel = max(level, VL_LOG_MIN_LEVEL);
+}
+
+
+int parseLevel(string_view name) {
+    for (int i = 0; i <= LEVEL_OFF; i++) {
+        if (name == LEVEL_NAMES[i]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+void setFormat(Format format) {
+    log::format = format;
+}
+
+
+/**
+ * fork 出的子进程中没有写出线程，改为同步写出。
+ */
+static void onForkChild() {
+    async.store(false, memory_order_relaxed);
+}
+
+
+void startAsync() {
+    if (async.load(memory_order_relaxed)) {
+        return;
+    }
+
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        slots[i].seq.store(i, memory_order_relaxed);
+    }
+    tail.store(0, memory_order_relaxed);
+    head = 0;
+    stopping.store(false, memory_order_relaxed);
+
+    // 写出线程不应接收任何信号，否则 SIGCHLD 等可能不会送到 signalfd。
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    writer = thread(writerMain);
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+
+    pthread_setname_np(writer.native_handle(), "vl-log");
+
+    static bool registered = false;
+    if (!registered) {
+        registered = true;
+        pthread_atfork(nullptr, nullptr, onForkChild);
+        atexit(stopAsync);
+    }
+
+    async.store(true, memory_order_release);
+}
+
+
+void stopAsync() {
+    if (!async.exchange(false, memory_order_acq_rel)) {
+        return;
+    }
+
+    stopping.store(true, memory_order_release);
+    wakeWriter();
+    writer.join();
 }
 
 } // namespace log
@@ -4,46 +4,249 @@
  * 日志工具
  *
  * 日志格式：
- * [main.cpp 32] xxx
- * 
+ * [2026-10-17 12:00:00] xxx
+ * 或每行一个 JSON 对象（见 Format）。
+ *
+ * 每行日志先在调用者的栈上拼好，再放入无锁环形缓冲，由后台线程批量写出。
+ * 调用者不会因 stderr 写得慢（如管道、journald）而阻塞；缓冲写满时丢弃新的日志。
+ *
  * 创建于 2023年12月26日 上海市嘉定区安亭镇
  */
 
 #pragma once
 
-#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
 #include "./ConsoleColorPad.h"
 
+/*
+ * 编译期最低日志级别。低于它的 LOG_* 调用不生成任何代码，参数也不会被求值。
+ * 由 CMake 选项 VL_LOG_MIN_LEVEL 设置。
+ */
+#ifndef VL_LOG_MIN_LEVEL
+    #define VL_LOG_MIN_LEVEL 0
+#endif
+
 namespace vl {
 namespace log {
 
-void printInfo(const char* filename, int line);
+/* 日志级别。 */
+
+constexpr int LEVEL_DEBUG = 0;
+constexpr int LEVEL_INFO = 1;
+constexpr int LEVEL_WARN = 2;
+constexpr int LEVEL_ERROR = 3;
+
+/** 关闭全部日志。 */
+constexpr int LEVEL_OFF = 4;
+
+/** 单行日志正文的最大长度。超出部分被截断。 */
+constexpr size_t MAX_LINE = 448;
+
+/** 单行日志最多携带的键值对数。超出的被丢弃。 */
+constexpr size_t MAX_FIELDS = 8;
+
+/* 颜色。与 ConsoleColorPad 的格式相同。 */
+
+inline constexpr const char* COLOR_INFO = "\e[1;38;2;255;255;255m";
+inline constexpr const char* COLOR_WARN = "\e[1;38;2;255;192;64m";
+inline constexpr const char* COLOR_ERROR = "\e[1;38;2;255;64;64m";
+inline constexpr const char* COLOR_TEMPORARY = "\e[1;38;2;128;128;255m";
+inline constexpr const char* COLOR_TODO = "\e[1;38;2;255;192;192m";
+
+
+enum class Format {
+    /** [时间] 正文 */
+    TEXT,
+
+    /**
+     * 每行一个 JSON 对象：
+     * {"time":"2026-10-17T12:00:00+0800","level":"info","file":"main.cpp","line":32,"msg":"..."}
+     * 通过 LOG_*_KV 记录的键值对放在 "fields" 对象中。
+     */
+    JSON
+};
+
+
+/** 运行时最低日志级别。不要直接修改，使用 setLevel()。 */
+extern int runtimeLevel;
+
+inline bool enabled(int level) {
+    return level >= runtimeLevel;
+}
+
+/**
+ * 设置运行时最低日志级别。不能低于编译期的 VL_LOG_MIN_LEVEL。
+ */
+void setLevel(int level);
+
+/**
+ * @return 级别名（debug、info、warn、error、off）对应的级别。无法识别时返回 -1。
+ */
+int parseLevel(std::string_view name);
+
+void setFormat(Format format);
+
+
+/**
+ * 启动后台写出线程。之前（以及 stopAsync() 之后）的日志直接同步写出。
+ * 需要在 daemonize 等 fork 之后调用：fork 出的子进程中没有写出线程。
+ */
+void startAsync();
+
+/**
+ * 写出缓冲中剩余的日志，并结束后台线程。进程退出时会自动调用。
+ */
+void stopAsync();
+
+/**
+ * 一个键值对。键与值都保存在所属行的正文缓冲中，以相对 text 的偏移表示。
+ */
+struct Field {
+    uint16_t key;
+    uint16_t keyLen;
+    uint16_t value;
+    uint16_t valueLen;
+
+    /** 值是整数。JSON 中不加引号。 */
+    bool number;
+};
+
+
+/**
+ * 提交一行日志。text 不含时间与换行。
+ *
+ * @param color 为 nullptr 时不设置颜色。
+ * @param len 消息的长度。键值对位于其后，由 fields 描述。
+ */
+void submit(
+    int level, const char* color, const char* file, int line, const char* text, size_t len,
+    const Field* fields = nullptr, size_t fieldCount = 0
+);
+
+
+/**
+ * 正在拼接的一行日志。
+ */
+struct Line {
+    char data[MAX_LINE];
+    size_t len = 0;
+
+    Field fields[MAX_FIELDS];
+    size_t fieldCount = 0;
+
+    void append(const char* s, size_t n) {
+        if (n > sizeof(data) - len) {
+            // 在完整的 UTF-8 字符处截断。
+            n = sizeof(data) - len;
+            while (n > 0 && (s[n] & 0xc0) == 0x80) {
+                n--;
+            }
+        }
+        memcpy(data + len, s, n);
+        len += n;
+    }
+};
+
 
-inline void printContent() {
-    std::clog << std::endl;
+inline void appendValue(Line& line, std::string_view v) {
+    line.append(v.data(), v.size());
 }
 
-template <typename T, typename... Args>
-inline void printContent(T value, Args... args) {
-    std::clog << value;
-    printContent(args...);
+inline void appendValue(Line& line, const char* v) {
+    appendValue(line, v ? std::string_view(v) : std::string_view("(null)"));
+}
+
+inline void appendValue(Line& line, char v) {
+    line.append(&v, 1);
+}
+
+template <typename T>
+    requires std::is_arithmetic_v<T> && (!std::is_same_v<T, char>)
+inline void appendValue(Line& line, T v) {
+    char buf[32];
+    std::to_chars_result res;
+    if constexpr (std::is_same_v<T, bool>) {
+        res = std::to_chars(buf, buf + sizeof(buf), int(v));
+    } else {
+        res = std::to_chars(buf, buf + sizeof(buf), v);
+    }
+    line.append(buf, res.ptr - buf);
 }
 
-inline void resetColor() {
-    ConsoleColorPad::setClogColor();
+/**
+ * 其他类型（如指针）。较慢，只应出现在少见的路径上。
+ */
+template <typename T>
+    requires (!std::is_arithmetic_v<T> && !std::is_convertible_v<const T&, std::string_view>)
+inline void appendValue(Line& line, const T& v) {
+    std::ostringstream os;
+    os << v;
+    appendValue(line, std::string_view(os.str()));
 }
 
-inline void setColorInfo() {
-    ConsoleColorPad::setClogColor(255, 255, 255);
+
+template <typename... Args>
+inline void print(int level, const char* color, const char* file, int lineNo, const Args&... args) {
+    Line line;
+    (appendValue(line, args), ...);
+    submit(level, color, file, lineNo, line.data, line.len);
 }
 
-inline void setColorWarn() {
-    ConsoleColorPad::setClogColor(255, 192, 64);
+
+template <typename T>
+inline void appendField(Line& line, const char* key, const T& value) {
+    if (line.fieldCount == MAX_FIELDS || line.len == sizeof(line.data)) {
+        return;
+    }
+
+    auto& field = line.fields[line.fieldCount];
+    field.key = uint16_t(line.len);
+    appendValue(line, key);
+    field.keyLen = uint16_t(line.len - field.key);
+    field.value = uint16_t(line.len);
+    appendValue(line, value);
+    field.valueLen = uint16_t(line.len - field.value);
+
+    // 写满时值可能被截断，整个丢弃，给之后较短的键值对留出空间。
+    if (line.len == sizeof(line.data)) {
+        line.len = field.key;
+        return;
+    }
+    field.number = std::is_integral_v<T> && !std::is_same_v<T, char>;
+    line.fieldCount++;
 }
 
-inline void setColorError() {
-    ConsoleColorPad::setClogColor(255, 64, 64);
+inline void appendFields(Line&) {}
+
+template <typename T, typename... Rest>
+inline void appendFields(Line& line, const char* key, const T& value, const Rest&... rest) {
+    appendField(line, key, value);
+    appendFields(line, rest...);
+}
+
+/**
+ * 消息后跟若干键值对：printFields(..., "spawned", "pid", pid, "cmd", cmd)。
+ */
+template <typename... Args>
+inline void printFields(
+    int level, const char* color, const char* file, int lineNo, std::string_view msg,
+    const Args&... fields
+) {
+    static_assert(sizeof...(Args) % 2 == 0, "fields must be key-value pairs.");
+
+    Line line;
+    appendValue(line, msg);
+    size_t msgLen = line.len;
+    appendFields(line, fields...);
+    submit(level, color, file, lineNo, line.data, msgLen, line.fields, line.fieldCount);
 }
 
 
@@ -55,56 +258,56 @@ inline void setColorError() {
     #define __FILE_NAME__ ""
 #endif
 
-#define LOG_PLAIN(...) \
+/*
+ * 级别低于 VL_LOG_MIN_LEVEL 时，if constexpr 的分支被丢弃，不生成代码；
+ * 否则先检查运行时级别，再拼接参数。
+ */
+#define VL_LOG(level, color, ...) \
     { \
-        vl::log::printInfo( \
-            __FILE_NAME__, __LINE__ \
-        ); \
-        vl::log::printContent(__VA_ARGS__); \
+        if constexpr (level >= VL_LOG_MIN_LEVEL) { \
+            if (vl::log::enabled(level)) { \
+                vl::log::print(level, color, __FILE_NAME__, __LINE__, __VA_ARGS__); \
+            } \
+        } \
     }
 
-#define LOG_INFO(...) \
+/*
+ * 带键值对的版本：LOG_INFO_KV("spawned", "pid", pid, "cmd", cmd)。
+ * 文本格式下输出为 "spawned pid=123 cmd=..."，JSON 格式下放在 "fields" 对象中，日志收集程序不必再从消息中解析。
+ */
+#define VL_LOG_KV(level, color, ...) \
     { \
-        vl::log::setColorInfo(); \
-        LOG_PLAIN(__VA_ARGS__); \
-        vl::log::resetColor(); \
+        if constexpr (level >= VL_LOG_MIN_LEVEL) { \
+            if (vl::log::enabled(level)) { \
+                vl::log::printFields(level, color, __FILE_NAME__, __LINE__, __VA_ARGS__); \
+            } \
+        } \
     }
 
-#define LOG_ERROR(...) \
-    { \
-        vl::log::setColorError(); \
-        LOG_PLAIN(__VA_ARGS__); \
-        vl::log::resetColor(); \
-    }
+#define LOG_PLAIN(...) VL_LOG(vl::log::LEVEL_INFO, nullptr, __VA_ARGS__)
+
+#define LOG_INFO(...) VL_LOG(vl::log::LEVEL_INFO, vl::log::COLOR_INFO, __VA_ARGS__)
+
+#define LOG_ERROR(...) VL_LOG(vl::log::LEVEL_ERROR, vl::log::COLOR_ERROR, __VA_ARGS__)
 
 #define LOG_ERROR_EXIT(...) \
     { \
-        vl::log::setColorError(); \
-        LOG_PLAIN(__VA_ARGS__); \
-        vl::log::resetColor(); \
+        VL_LOG(vl::log::LEVEL_ERROR, vl::log::COLOR_ERROR, __VA_ARGS__); \
         exit(-1); \
     }
 
-#define LOG_WARN(...) \
-    { \
-        vl::log::setColorWarn(); \
-        LOG_PLAIN(__VA_ARGS__); \
-        vl::log::resetColor(); \
-    }
+#define LOG_WARN(...) VL_LOG(vl::log::LEVEL_WARN, vl::log::COLOR_WARN, __VA_ARGS__)
 
-#if 1
-    #define LOG_TEMPORARY(...) { \
-        ConsoleColorPad::setClogColor(128, 128, 255); \
-        LOG_PLAIN(__VA_ARGS__); \
-        vl::log::resetColor(); \
-    }
-#endif
+#define LOG_INFO_KV(...) VL_LOG_KV(vl::log::LEVEL_INFO, vl::log::COLOR_INFO, __VA_ARGS__)
+
+#define LOG_WARN_KV(...) VL_LOG_KV(vl::log::LEVEL_WARN, vl::log::COLOR_WARN, __VA_ARGS__)
 
-#if 1
-    #define TODO(...) { \
-        ConsoleColorPad::setClogColor(255, 192, 192); \
-        LOG_PLAIN("TODO: ", __VA_ARGS__); \
-        vl::log::resetColor(); \
+#define LOG_ERROR_KV(...) VL_LOG_KV(vl::log::LEVEL_ERROR, vl::log::COLOR_ERROR, __VA_ARGS__)
+
+#define LOG_TEMPORARY(...) VL_LOG(vl::log::LEVEL_DEBUG, vl::log::COLOR_TEMPORARY, __VA_ARGS__)
+
+#define TODO(...) \
+    { \
+        VL_LOG(vl::log::LEVEL_ERROR, vl::log::COLOR_TODO, "TODO: ", __VA_ARGS__); \
         exit(-1); \
     }
-#endif
@@ -0,0 +1,544 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 编译期生成的报文编解码
+ * 创建于 2026年10月17日
+ *
+ * 每种报文只需声明一次字段布局（Fields），编码、解码、长度计算
+ * 以及按 type 分发的跳转表都由模板在编译期生成，运行时没有虚函数调用。
+ *
+ * 例：
+ *
+ *   struct Foo {
+ *       static constexpr uint32_t typeCode = 0x0003;
+ *       static constexpr const char* name = "Foo";
+ *
+ *       uint32_t a;
+ *       std::string_view b;
+ *
+ *       using Fields = FieldList<
+ *           Field<&Foo::a, Int<uint32_t>>,
+ *           Field<&Foo::b, Bytes<uint64_t>>
+ *       >;
+ *   };
+ */
+
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <endian.h>
+
+namespace vl {
+namespace protocol {
+
+inline const char* MAGIC_STR = "OycF";
+const int HEADER_LEN = 16;
+
+
+/* ------------ 大端读写 ------------ */
+
+// 报文数据不保证对齐，统一通过 memcpy 读写。
+
+template <typename T>
+inline T readBE(const char* p) {
+    static_assert(std::is_integral_v<T>);
+
+    std::make_unsigned_t<T> v;
+    memcpy(&v, p, sizeof(v));
+    if constexpr (sizeof(T) == 2) {
+        v = be16toh(v);
+    } else if constexpr (sizeof(T) == 4) {
+        v = be32toh(v);
+    } else if constexpr (sizeof(T) == 8) {
+        v = be64toh(v);
+    }
+    return T(v);
+}
+
+template <typename T>
+inline char* writeBE(char* p, T value) {
+    static_assert(std::is_integral_v<T>);
+
+    auto v = std::make_unsigned_t<T>(value);
+    if constexpr (sizeof(T) == 2) {
+        v = htobe16(v);
+    } else if constexpr (sizeof(T) == 4) {
+        v = htobe32(v);
+    } else if constexpr (sizeof(T) == 8) {
+        v = htobe64(v);
+    }
+    memcpy(p, &v, sizeof(v));
+    return p + sizeof(v);
+}
+
+inline uint32_t readBE32(const char* p) { return readBE<uint32_t>(p); }
+inline uint64_t readBE64(const char* p) { return readBE<uint64_t>(p); }
+inline char* writeBE32(char* p, uint32_t v) { return writeBE(p, v); }
+inline char* writeBE64(char* p, uint64_t v) { return writeBE(p, v); }
+
+
+/* ------------ 输入与输出 ------------ */
+
+/**
+ * 报文编码的输出端。
+ *
+ * 定长部分通过 reserve() 写入输出端自己的缓冲；
+ * 较长的字节数组可以通过 reference() 直接引用，由输出端在发送时聚集（writev）。
+ */
+class Encoder {
+public:
+    /**
+     * 在输出缓冲末尾预留 n 字节，返回写入位置。
+     * 返回的指针在下一次调用 reserve() 前有效。
+     */
+    virtual char* reserve(size_t n) = 0;
+
+    /**
+     * 引用一段外部数据，不拷贝。数据需要保持有效，直到被发送出去。
+     */
+    virtual void reference(const char* data, size_t len) = 0;
+
+    virtual ~Encoder() {}
+};
+
+
+/**
+ * 带越界检查的 body 读取器。
+ */
+struct Reader {
+    const char* data;
+    size_t left;
+
+    /**
+     * 取出 n 字节。剩余不足时返回 nullptr。
+     */
+    const char* take(uint64_t n) {
+        if (n > left) {
+            return nullptr;
+        }
+
+        const char* p = data;
+        data += n;
+        left -= n;
+        return p;
+    }
+};
+
+
+/**
+ * 可选择零拷贝编码的字节数组。
+ * isStatic 为 true 时（如字符串常量），编码时直接引用 view 而不拷贝。
+ */
+struct Text {
+    std::string_view view;
+    bool isStatic = false;
+};
+
+
+/* ------------ 字段编码方式 ------------ */
+
+/**
+ * 大端整数。
+ */
+template <typename T>
+struct Int {
+    using Value = T;
+
+    static constexpr size_t minSize = sizeof(T);
+    static constexpr size_t fixedSize = sizeof(T);
+
+    static uint64_t size(const T&) { return sizeof(T); }
+
+    static char* write(char* p, const T& v) { return writeBE(p, v); }
+
+    static void encode(Encoder& out, const T& v) { write(out.reserve(sizeof(T)), v); }
+
+    static bool decode(Reader& in, T& v) {
+        const char* p = in.take(sizeof(T));
+        if (!p) {
+            return false;
+        }
+
+        v = readBE<T>(p);
+        return true;
+    }
+};
+
+
+/**
+ * 带长度前缀的字节数组。解码结果直接引用报文数据。
+ */
+template <typename LenT>
+struct Bytes {
+    using Value = std::string_view;
+
+    static constexpr size_t minSize = sizeof(LenT);
+    static constexpr size_t fixedSize = 0;
+
+    static uint64_t size(const Value& v) { return sizeof(LenT) + v.size(); }
+
+    static void encode(Encoder& out, const Value& v) {
+        char* p = out.reserve(sizeof(LenT) + v.size());
+        p = writeBE(p, LenT(v.size()));
+
+        // 空的 string_view 的 data() 可能为 nullptr，不能传给 memcpy。
+        if (!v.empty()) {
+            memcpy(p, v.data(), v.size());
+        }
+    }
+
+    static bool decode(Reader& in, Value& v) {
+        const char* p = in.take(sizeof(LenT));
+        if (!p) {
+            return false;
+        }
+
+        auto len = readBE<LenT>(p);
+        if (!(p = in.take(len))) {
+            return false;
+        }
+
+        v = Value(p, len);
+        return true;
+    }
+};
+
+
+/**
+ * 带长度前缀的 Text。只用于编码。
+ */
+template <typename LenT>
+struct TextBytes {
+    using Value = Text;
+
+    static constexpr size_t minSize = sizeof(LenT);
+    static constexpr size_t fixedSize = 0;
+
+    static uint64_t size(const Value& v) { return sizeof(LenT) + v.view.size(); }
+
+    static void encode(Encoder& out, const Value& v) {
+        if (v.isStatic) {
+            writeBE(out.reserve(sizeof(LenT)), LenT(v.view.size()));
+            out.reference(v.view.data(), v.view.size());
+        } else {
+            Bytes<LenT>::encode(out, v.view);
+        }
+    }
+
+    static bool decode(Reader& in, Value& v) {
+        v.isStatic = false;
+        return Bytes<LenT>::decode(in, v.view);
+    }
+};
+
+
+/**
+ * 带数量前缀的列表。
+ */
+template <typename CountT, typename Elem>
+struct Seq {
+    using Value = std::vector<typename Elem::Value>;
+
+    static constexpr size_t minSize = sizeof(CountT);
+    static constexpr size_t fixedSize = 0;
+
+    static uint64_t size(const Value& v) {
+        if constexpr (Elem::fixedSize > 0) {
+            return sizeof(CountT) + v.size() * Elem::fixedSize;
+        } else {
+            uint64_t res = sizeof(CountT);
+            for (auto& it : v) {
+                res += Elem::size(it);
+            }
+            return res;
+        }
+    }
+
+    static void encode(Encoder& out, const Value& v) {
+        if constexpr (Elem::fixedSize > 0) {
+            // 定长元素：一次预留，连续写入。
+            char* p = out.reserve(sizeof(CountT) + v.size() * Elem::fixedSize);
+            p = writeBE(p, CountT(v.size()));
+            for (auto& it : v) {
+                p = Elem::write(p, it);
+            }
+        } else {
+            writeBE(out.reserve(sizeof(CountT)), CountT(v.size()));
+            for (auto& it : v) {
+                Elem::encode(out, it);
+            }
+        }
+    }
+
+    /**
+     * 解码到 v。v 的容量会被保留，反复解码时不需要再次分配。
+     */
+    static bool decode(Reader& in, Value& v) {
+        const char* p = in.take(sizeof(CountT));
+        if (!p) {
+            return false;
+        }
+
+        auto count = readBE<CountT>(p);
+
+        // 先按元素最小长度检查，避免按伪造的数量预留内存。
+        if (uint64_t(count) * Elem::minSize > in.left) {
+            return false;
+        }
+
+        v.resize(count);
+        for (auto& it : v) {
+            if (!Elem::decode(in, it)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+
+/**
+ * 可省略的结尾字段。body 已读完时取空值。
+ * 只能作为报文的最后一个字段，用于向后兼容地扩展已有报文。
+ */
+template <typename Inner>
+struct Optional {
+    using Value = typename Inner::Value;
+
+    static constexpr size_t minSize = 0;
+    static constexpr size_t fixedSize = 0;
+
+    static uint64_t size(const Value& v) { return Inner::size(v); }
+
+    static void encode(Encoder& out, const Value& v) { Inner::encode(out, v); }
+
+    static bool decode(Reader& in, Value& v) {
+        if (in.left == 0) {
+            // 保留容器的容量。
+            if constexpr (requires { v.clear(); }) {
+                v.clear();
+            } else {
+                v = Value();
+            }
+            return true;
+        }
+
+        return Inner::decode(in, v);
+    }
+};
+
+
+/**
+ * 绑定到成员变量的字段。
+ */
+template <auto Member, typename Codec>
+struct Field {
+    template <typename M>
+    static uint64_t size(const M& m) { return Codec::size(m.*Member); }
+
+    template <typename M>
+    static void encode(Encoder& out, const M& m) { Codec::encode(out, m.*Member); }
+
+    template <typename M>
+    static bool decode(Reader& in, M& m) { return Codec::decode(in, m.*Member); }
+
+    /** 只适用于定长字段。 */
+    template <typename M>
+    static char* write(char* p, const M& m) { return Codec::write(p, m.*Member); }
+
+    static constexpr size_t minSize = Codec::minSize;
+    static constexpr size_t fixedSize = Codec::fixedSize;
+};
+
+
+template <typename... Fs>
+struct FieldList {
+    template <typename M>
+    static uint64_t size(const M& m) { return (uint64_t(0) + ... + Fs::size(m)); }
+
+    template <typename M>
+    static void encode(Encoder& out, const M& m) { (Fs::encode(out, m), ...); }
+
+    template <typename M>
+    static bool decode(Reader& in, M& m) { return (Fs::decode(in, m) && ...); }
+
+    static constexpr size_t minSize = (size_t(0) + ... + Fs::minSize);
+
+    /** 所有字段都定长时为总长度，否则为 0。 */
+    static constexpr size_t fixedSize = ((Fs::fixedSize > 0) && ...)
+        ? (size_t(0) + ... + Fs::fixedSize) : 0;
+};
+
+
+/**
+ * 嵌套结构体。S 需要声明 Fields。
+ */
+template <typename S>
+struct Struct {
+    using Value = S;
+
+    static constexpr size_t minSize = S::Fields::minSize;
+    static constexpr size_t fixedSize = S::Fields::fixedSize;
+
+    static uint64_t size(const S& v) { return S::Fields::size(v); }
+
+    static char* write(char* p, const S& v) {
+        static_assert(fixedSize > 0, "write() requires a fixed-size struct.");
+        return writeFields(p, v, (typename S::Fields*) nullptr);
+    }
+
+    static void encode(Encoder& out, const S& v) { S::Fields::encode(out, v); }
+
+    static bool decode(Reader& in, S& v) { return S::Fields::decode(in, v); }
+
+private:
+    template <typename... Fs>
+    static char* writeFields(char* p, const S& v, FieldList<Fs...>*) {
+        ((p = Fs::write(p, v)), ...);
+        return p;
+    }
+};
+
+
+/* ------------ 报文 ------------ */
+
+/**
+ * 报文 body 长度。
+ */
+template <typename M>
+inline uint64_t bodyLength(const M& msg) {
+    return M::Fields::size(msg);
+}
+
+
+/**
+ * 编码一条完整报文（含 header）。
+ */
+template <typename M>
+inline void encode(const M& msg, Encoder& out) {
+    char* header = out.reserve(HEADER_LEN);
+    memcpy(header, MAGIC_STR, 4);
+    writeBE32(header + 4, M::typeCode);
+    writeBE64(header + 8, bodyLength(msg));
+
+    M::Fields::encode(out, msg);
+}
+
+
+/**
+ * 解码 body。结果中的字节数组直接引用 body。
+ *
+ * @return 成功时返回 0。
+ */
+template <typename M>
+inline int decodeBody(const char* body, size_t len, M& msg) {
+    Reader in { body, len };
+    return M::Fields::decode(in, msg) ? 0 : -1;
+}
+
+
+/* ------------ 报文注册表 ------------ */
+
+template <typename... Ms>
+struct MessageList {
+    static constexpr size_t count = sizeof...(Ms);
+
+    /**
+     * 每种报文各一个实例。供解码反复使用。
+     */
+    using Pool = std::tuple<Ms...>;
+
+    static constexpr bool typeCodesUnique() {
+        std::array<uint32_t, sizeof...(Ms)> codes { Ms::typeCode... };
+        for (size_t i = 0; i < codes.size(); i++) {
+            for (size_t j = i + 1; j < codes.size(); j++) {
+                if (codes[i] == codes[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static constexpr uint32_t maxTypeCode() {
+        uint32_t res = 0;
+        ((res = Ms::typeCode > res ? Ms::typeCode : res), ...);
+        return res;
+    }
+};
+
+
+/** dispatch 函数的返回值：报文 body 无法解码。 */
+const int DISPATCH_DECODE_FAILED = INT_MIN;
+
+/** dispatch 函数的返回值：没有与 type 对应的报文。 */
+const int DISPATCH_UNKNOWN_TYPE = INT_MIN + 1;
+
+
+/**
+ * 按 type 分发报文的跳转表。
+ *
+ * Handlers 需要为 List 中的每种报文 M 提供 static int handle(const M&, Context&)。
+ * 缺少任意一个都会在编译期报错。
+ */
+template <typename List, typename Handlers, typename Context>
+class DispatchTable;
+
+template <typename... Ms, typename Handlers, typename Context>
+class DispatchTable<MessageList<Ms...>, Handlers, Context> {
+public:
+    using Pool = typename MessageList<Ms...>::Pool;
+
+    /**
+     * 解码 body 并调用对应的 handle()。
+     *
+     * @return handle() 的返回值；或 DISPATCH_DECODE_FAILED、DISPATCH_UNKNOWN_TYPE。
+     */
+    static int dispatch(uint32_t type, const char* body, size_t len, Pool& pool, Context& ctx) {
+        if (type >= table.size() || table[type] == nullptr) {
+            return DISPATCH_UNKNOWN_TYPE;
+        }
+
+        return table[type](body, len, pool, ctx);
+    }
+
+private:
+    using Fn = int (*)(const char*, size_t, Pool&, Context&);
+
+    static_assert(MessageList<Ms...>::typeCodesUnique(), "duplicated type code.");
+    static_assert(
+        MessageList<Ms...>::maxTypeCode() < 256,
+        "request type codes are expected to be small enough for a direct jump table."
+    );
+
+    template <typename M>
+    static int decodeAndHandle(const char* body, size_t len, Pool& pool, Context& ctx) {
+        M& msg = std::get<M>(pool);
+        if (decodeBody(body, len, msg)) {
+            return DISPATCH_DECODE_FAILED;
+        }
+
+        return Handlers::handle(msg, ctx);
+    }
+
+    static constexpr auto buildTable() {
+        std::array<Fn, MessageList<Ms...>::maxTypeCode() + 1> res {};
+        ((res[Ms::typeCode] = &decodeAndHandle<Ms>), ...);
+        return res;
+    }
+
+    static constexpr auto table = buildTable();
+};
+
+} // namespace protocol
+} // namespace vl
@@ -3,81 +3,444 @@
 /*
  * vesper launcher socket 通信协议
  * 创建于 2024年2月27日 上海市嘉定区
+ *
+ * 报文只需在此声明字段布局，并加入 Requests 或 Responses。
+ * 编解码由 ProtocolCodec.h 在编译期生成。
  */
 
 #pragma once
 
 #include <cstdint>
-#include <sstream>
-#include <string>
+#include <string_view>
+#include <vector>
 
-#include "./Log.h"
-
-#ifndef __packed
-    #define __packed __attribute__((packed))
-#endif
+#include "./ProtocolCodec.h"
 
 namespace vl {
 namespace protocol {
 
-inline const char* MAGIC_STR = "OycF";
-const int HEADER_LEN = 16;
 
-#define VESPER_CTRL_PROTO_DECL_GET_TYPE() \
-    virtual uint32_t getType() const override;
+/* ------------ 应答 ------------ */
 
-class Base {
-public:
-    static const uint32_t typeCode = 0;
-    virtual inline uint32_t getType() const = 0;
-    void encode(std::stringstream& container) const;
+struct Response {
+    static constexpr uint32_t typeCode = 0xA001;
+    static constexpr const char* name = "Response";
 
-    virtual int decodeBody(const char* data, int len);
+    uint32_t code;
+    Text msg;
 
-    virtual ~Base() {}
-protected:
-    virtual uint64_t bodyLength() const;
-    virtual void encodeBody(std::stringstream& container) const;
+    using Fields = FieldList<
+        Field<&Response::code, Int<uint32_t>>,
+        Field<&Response::msg, TextBytes<uint32_t>>
+    >;
 };
 
 
-class Response : public Base {
-public:
-    static const uint32_t typeCode = 0xA001;
-    VESPER_CTRL_PROTO_DECL_GET_TYPE()
+struct BatchLaunchResponse {
+    static constexpr uint32_t typeCode = 0xA002;
+    static constexpr const char* name = "BatchLaunchResponse";
+
+    struct Entry {
+        uint32_t code;
+        int32_t pid;
+
+        using Fields = FieldList<
+            Field<&Entry::code, Int<uint32_t>>,
+            Field<&Entry::pid, Int<int32_t>>
+        >;
+    };
+
+    /** 全部启动成功时为 0。 */
     uint32_t code;
-    std::string msg;
+    std::vector<Entry> entries;
+
+    using Fields = FieldList<
+        Field<&BatchLaunchResponse::code, Int<uint32_t>>,
+        Field<&BatchLaunchResponse::entries, Seq<uint32_t, Struct<Entry>>>
+    >;
+};
+
+
+/**
+ * 子进程退出事件。推送给订阅了 EVENT_CHILD_EXIT 的连接。
+ */
+struct ChildExitEvent {
+    static constexpr uint32_t typeCode = 0xA003;
+    static constexpr const char* name = "ChildExitEvent";
+
+    static constexpr uint32_t REASON_EXITED = 1;
+    static constexpr uint32_t REASON_KILLED = 2;
+    static constexpr uint32_t REASON_DUMPED = 3;
+
+    int32_t pid;
+
+    /** REASON_*。 */
+    uint32_t reason;
+
+    /** 正常退出时为退出码，否则为信号编号。 */
+    int32_t value;
+
+    /** 是否是 launcher 启动的进程。为 0 时是被过继给 launcher 的孤儿进程。 */
+    uint32_t tracked;
+
+    /* 资源用量。时间单位为微秒，maxRss 单位为 KiB。 */
+
+    uint64_t userTime;
+    uint64_t systemTime;
+    uint64_t maxRss;
+    uint64_t minorFaults;
+    uint64_t majorFaults;
+    uint64_t voluntarySwitches;
+    uint64_t involuntarySwitches;
+
+    using Fields = FieldList<
+        Field<&ChildExitEvent::pid, Int<int32_t>>,
+        Field<&ChildExitEvent::reason, Int<uint32_t>>,
+        Field<&ChildExitEvent::value, Int<int32_t>>,
+        Field<&ChildExitEvent::tracked, Int<uint32_t>>,
+        Field<&ChildExitEvent::userTime, Int<uint64_t>>,
+        Field<&ChildExitEvent::systemTime, Int<uint64_t>>,
+        Field<&ChildExitEvent::maxRss, Int<uint64_t>>,
+        Field<&ChildExitEvent::minorFaults, Int<uint64_t>>,
+        Field<&ChildExitEvent::majorFaults, Int<uint64_t>>,
+        Field<&ChildExitEvent::voluntarySwitches, Int<uint64_t>>,
+        Field<&ChildExitEvent::involuntarySwitches, Int<uint64_t>>
+    >;
+};
+
+
+/**
+ * 子进程状态查询的应答。
+ */
+struct StatusResponse {
+    static constexpr uint32_t typeCode = 0xA004;
+    static constexpr const char* name = "StatusResponse";
+
+    struct Entry {
+        int32_t pid;
+
+        /** /proc/<pid>/stat 中的状态字符。采集失败时为 '?'。 */
+        uint32_t state;
+
+        /** 启动时刻。Unix 时间，单位为微秒。 */
+        uint64_t startTime;
+
+        /* CPU 时间，单位为微秒；rss 单位为 KiB。 */
+
+        uint64_t userTime;
+        uint64_t systemTime;
+        uint64_t rss;
+        uint64_t readBytes;
+        uint64_t writeBytes;
+
+        /** 采样距今的时长。单位为微秒。 */
+        uint64_t sampleAge;
+
+        std::string_view cmd;
+
+        using Fields = FieldList<
+            Field<&Entry::pid, Int<int32_t>>,
+            Field<&Entry::state, Int<uint32_t>>,
+            Field<&Entry::startTime, Int<uint64_t>>,
+            Field<&Entry::userTime, Int<uint64_t>>,
+            Field<&Entry::systemTime, Int<uint64_t>>,
+            Field<&Entry::rss, Int<uint64_t>>,
+            Field<&Entry::readBytes, Int<uint64_t>>,
+            Field<&Entry::writeBytes, Int<uint64_t>>,
+            Field<&Entry::sampleAge, Int<uint64_t>>,
+            Field<&Entry::cmd, Bytes<uint32_t>>
+        >;
+    };
+
+    uint32_t code;
+    std::vector<Entry> entries;
+
+    using Fields = FieldList<
+        Field<&StatusResponse::code, Int<uint32_t>>,
+        Field<&StatusResponse::entries, Seq<uint32_t, Struct<Entry>>>
+    >;
+};
+
+
+/**
+ * 子进程的一段输出。启动时设置了 LaunchOption::KEY_CAPTURE_OUTPUT 才会推送。
+ */
+struct OutputChunk {
+    static constexpr uint32_t typeCode = 0xA005;
+    static constexpr const char* name = "OutputChunk";
+
+    static constexpr uint32_t STREAM_STDOUT = 1 << 0;
+    static constexpr uint32_t STREAM_STDERR = 1 << 1;
+
+    int32_t pid;
+
+    /** STREAM_* 之一。 */
+    uint32_t stream;
+
+    /** 为空表示该流已结束。 */
+    std::string_view data;
+
+    using Fields = FieldList<
+        Field<&OutputChunk::pid, Int<int32_t>>,
+        Field<&OutputChunk::stream, Int<uint32_t>>,
+        Field<&OutputChunk::data, Bytes<uint32_t>>
+    >;
+};
+
+
+/**
+ * 运行统计的应答。
+ */
+struct StatsResponse {
+    static constexpr uint32_t typeCode = 0xA006;
+    static constexpr const char* name = "StatsResponse";
+
+    struct Counter {
+        std::string_view name;
+        uint64_t value;
+
+        using Fields = FieldList<
+            Field<&Counter::name, Bytes<uint32_t>>,
+            Field<&Counter::value, Int<uint64_t>>
+        >;
+    };
+
+    /** 直方图中的一个非空桶。样本值位于 [lower, upper]。 */
+    struct Bucket {
+        uint64_t lower;
+        uint64_t upper;
+        uint64_t count;
+
+        using Fields = FieldList<
+            Field<&Bucket::lower, Int<uint64_t>>,
+            Field<&Bucket::upper, Int<uint64_t>>,
+            Field<&Bucket::count, Int<uint64_t>>
+        >;
+    };
+
+    /** 延迟直方图。单位均为纳秒；百分位数精确到桶。 */
+    struct Histogram {
+        std::string_view name;
+        uint64_t count;
+        uint64_t sum;
+        uint64_t min;
+        uint64_t max;
+        uint64_t p50;
+        uint64_t p90;
+        uint64_t p99;
+        uint64_t p999;
+        std::vector<Bucket> buckets;
+
+        using Fields = FieldList<
+            Field<&Histogram::name, Bytes<uint32_t>>,
+            Field<&Histogram::count, Int<uint64_t>>,
+            Field<&Histogram::sum, Int<uint64_t>>,
+            Field<&Histogram::min, Int<uint64_t>>,
+            Field<&Histogram::max, Int<uint64_t>>,
+            Field<&Histogram::p50, Int<uint64_t>>,
+            Field<&Histogram::p90, Int<uint64_t>>,
+            Field<&Histogram::p99, Int<uint64_t>>,
+            Field<&Histogram::p999, Int<uint64_t>>,
+            Field<&Histogram::buckets, Seq<uint32_t, Struct<Bucket>>>
+        >;
+    };
+
+    uint32_t code;
+
+    /** launcher 启动至今的时长。单位为微秒。 */
+    uint64_t uptime;
 
-protected:
-    virtual uint64_t bodyLength() const;
-    virtual void encodeBody(std::stringstream& container) const override;
+    std::vector<Counter> counters;
+    std::vector<Histogram> histograms;
+
+    using Fields = FieldList<
+        Field<&StatsResponse::code, Int<uint32_t>>,
+        Field<&StatsResponse::uptime, Int<uint64_t>>,
+        Field<&StatsResponse::counters, Seq<uint32_t, Struct<Counter>>>,
+        Field<&StatsResponse::histograms, Seq<uint32_t, Struct<Histogram>>>
+    >;
+};
+
+
+/* ------------ 请求 ------------ */
+
+/**
+ * 启动选项。作为启动请求末尾的可选列表，省略时不做限制。
+ */
+struct LaunchOption {
+    /** RLIMIT_AS。单位为 Byte。 */
+    static constexpr uint32_t KEY_ADDRESS_SPACE = 1;
+
+    /** RLIMIT_CPU。单位为秒。 */
+    static constexpr uint32_t KEY_CPU_TIME = 2;
+
+    /** RLIMIT_NOFILE。 */
+    static constexpr uint32_t KEY_OPEN_FILES = 3;
+
+    /** 允许运行的 CPU 编号。可出现多次，取并集。 */
+    static constexpr uint32_t KEY_CPU = 4;
+
+    /** nice 值。按 int64 解释。 */
+    static constexpr uint32_t KEY_NICE = 5;
+
+    /** SCHED_* 调度策略。 */
+    static constexpr uint32_t KEY_SCHED_POLICY = 6;
+
+    /** 实时调度优先级。 */
+    static constexpr uint32_t KEY_SCHED_PRIORITY = 7;
+
+    /** IOPRIO_CLASS_* I/O 调度类。 */
+    static constexpr uint32_t KEY_IO_CLASS = 8;
+
+    /** I/O 优先级，0 ~ 7。 */
+    static constexpr uint32_t KEY_IO_LEVEL = 9;
+
+    /** 把子进程的输出以 OutputChunk 推送给 client。OutputChunk::STREAM_* 的组合。 */
+    static constexpr uint32_t KEY_CAPTURE_OUTPUT = 10;
+
+    uint32_t key;
+    uint64_t value;
+
+    using Fields = FieldList<
+        Field<&LaunchOption::key, Int<uint32_t>>,
+        Field<&LaunchOption::value, Int<uint64_t>>
+    >;
 };
 
+using LaunchOptions = Optional<Seq<uint32_t, Struct<LaunchOption>>>;
+
 
-class ShellLaunch : public Base {
-public:
-    static const uint32_t typeCode = 0x0001;
-    VESPER_CTRL_PROTO_DECL_GET_TYPE()
+struct ShellLaunch {
+    static constexpr uint32_t typeCode = 0x0001;
+    static constexpr const char* name = "ShellLaunch";
 
-    virtual int decodeBody(const char* data, int len) override;
+    std::string_view cmd;
 
-    std::string cmd;
+    std::vector<LaunchOption> options;
 
+    using Fields = FieldList<
+        Field<&ShellLaunch::cmd, Bytes<uint64_t>>,
+        Field<&ShellLaunch::options, LaunchOptions>
+    >;
+};
+
+
+struct BatchShellLaunch {
+    static constexpr uint32_t typeCode = 0x0002;
+    static constexpr const char* name = "BatchShellLaunch";
+
+    std::vector<std::string_view> cmds;
+
+    /** 对每条命令生效。 */
+    std::vector<LaunchOption> options;
+
+    using Fields = FieldList<
+        Field<&BatchShellLaunch::cmds, Seq<uint32_t, Bytes<uint64_t>>>,
+        Field<&BatchShellLaunch::options, LaunchOptions>
+    >;
 };
 
 
 /**
- * 
- * 
- * @param data 指向报文开头。调用者需要确保 magic 正确。
- * @param len 整个报文长度。包含 header。调用者需要确保这个值不小于 16。
- * 
- * @return 失败时，返回 nullptr.
+ * 不经过 /bin/sh，直接 execve 启动程序。
  */
-Base* decode(const char* data, uint32_t type, int len);
+struct ExecLaunch {
+    static constexpr uint32_t typeCode = 0x0003;
+    static constexpr const char* name = "ExecLaunch";
+
+    /** 可执行文件路径。不会在 PATH 中查找。 */
+    std::string_view path;
+
+    /** 为空时使用 { path }。 */
+    std::vector<std::string_view> argv;
+
+    /** 形如 KEY=VALUE。为空时继承 launcher 的环境变量。 */
+    std::vector<std::string_view> env;
+
+    /** 为空时继承 launcher 的工作目录。 */
+    std::string_view cwd;
+
+    std::vector<LaunchOption> options;
 
+    using Fields = FieldList<
+        Field<&ExecLaunch::path, Bytes<uint64_t>>,
+        Field<&ExecLaunch::argv, Seq<uint32_t, Bytes<uint64_t>>>,
+        Field<&ExecLaunch::env, Seq<uint32_t, Bytes<uint64_t>>>,
+        Field<&ExecLaunch::cwd, Bytes<uint64_t>>,
+        Field<&ExecLaunch::options, LaunchOptions>
+    >;
+};
+
+
+/**
+ * 订阅服务端推送的事件。
+ */
+struct Subscribe {
+    static constexpr uint32_t typeCode = 0x0004;
+    static constexpr const char* name = "Subscribe";
+
+    static constexpr uint32_t EVENT_CHILD_EXIT = 1 << 0;
+
+    /** EVENT_* 的组合。为 0 时取消订阅。 */
+    uint32_t events;
+
+    using Fields = FieldList<
+        Field<&Subscribe::events, Int<uint32_t>>
+    >;
+};
+
+
+/**
+ * 查询 launcher 启动的、仍在运行的子进程。应答为 StatusResponse。
+ */
+struct StatusQuery {
+    static constexpr uint32_t typeCode = 0x0005;
+    static constexpr const char* name = "StatusQuery";
+
+    using Fields = FieldList<>;
+};
+
+
+/**
+ * 查询 launcher 的运行统计。应答为 StatsResponse。
+ */
+struct StatsQuery {
+    static constexpr uint32_t typeCode = 0x0006;
+    static constexpr const char* name = "StatsQuery";
+
+    using Fields = FieldList<>;
+};
+
+
+/* ------------ 注册表 ------------ */
+
+/** 客户端可以发来的报文。 */
+using Requests = MessageList<
+    ShellLaunch,
+    BatchShellLaunch,
+    ExecLaunch,
+    Subscribe,
+    StatusQuery,
+    StatsQuery
+>;
+
+/** 服务端发出的报文。 */
+using Responses = MessageList<
+    Response,
+    BatchLaunchResponse,
+    ChildExitEvent,
+    StatusResponse,
+    OutputChunk,
+    StatsResponse
+>;
+
+
+/**
+ * 每种请求报文各保留一个实例，供解码反复使用。
+ * 每个连接持有一个，稳定运行时解码不需要分配内存。
+ */
+using MessagePool = Requests::Pool;
 
-#undef VESPER_CTRL_PROTO_DECL_GET_TYPE
 
 } // namespace protocol
 } // namespace vl
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 请求处理过程的耗时追踪
+ * 创建于 2026年10月17日
+ */
+
+#include "./Trace.h"
+#include "./Log.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace vl {
+namespace trace {
+
+bool active = false;
+
+static string outputPath;
+
+struct Event {
+    const char* category;
+    const char* name;
+    uint64_t begin;
+
+    /** 为 UINT64_MAX 时是瞬时事件。 */
+    uint64_t duration;
+
+    uint64_t request;
+};
+
+/**
+ * 单个线程的事件缓冲。只有所属线程写入；dump() 可能在其他线程读取，
+ * 此时正被覆盖的那个事件可能不完整。
+ */
+struct ThreadBuffer {
+    pid_t tid;
+    unique_ptr<Event[]> events;
+
+    /** 累计写入的事件数。 */
+    atomic<uint64_t> written { 0 };
+};
+
+/** 所有线程的缓冲。线程退出后仍保留，以便退出时写出。 */
+static mutex registryLock;
+static vector<unique_ptr<ThreadBuffer>> registry;
+
+thread_local ThreadBuffer* localBuffer = nullptr;
+thread_local uint64_t currentRequest = 0;
+
+
+static ThreadBuffer* threadBuffer() {
+    if (localBuffer == nullptr) {
+        auto buffer = make_unique<ThreadBuffer>();
+        buffer->tid = gettid();
+        buffer->events = make_unique<Event[]>(BUFFER_EVENTS);
+        localBuffer = buffer.get();
+
+        lock_guard<mutex> lock(registryLock);
+        registry.push_back(std::move(buffer));
+    }
+
+    return localBuffer;
+}
+
+
+static void record(const Event& event) {
+    auto* buffer = threadBuffer();
+    uint64_t n = buffer->written.load(memory_order_relaxed);
+    buffer->events[n % BUFFER_EVENTS] = event;
+    buffer->written.store(n + 1, memory_order_release);
+}
+
+
+void setRequest(uint64_t id) {
+    currentRequest = id;
+}
+
+
+void complete(const char* category, const char* name, uint64_t begin, uint64_t end) {
+    record({ category, name, begin, end - begin, currentRequest });
+}
+
+
+void instant(const char* category, const char* name) {
+    if (enabled()) {
+        record({ category, name, now(), UINT64_MAX, currentRequest });
+    }
+}
+
+
+int enable(const string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        LOG_ERROR("failed to open trace file ", path, ": ", strerror(errno));
+        return -1;
+    }
+    fclose(f);
+
+    outputPath = path;
+    active = true;
+
+    atexit([] { dump(); });
+
+    return 0;
+}
+
+
+/**
+ * 以微秒为单位输出纳秒时间，保留 3 位小数。
+ */
+static void printMicros(FILE* f, uint64_t nanos) {
+    fprintf(f, "%" PRIu64 ".%03u", nanos / 1000, unsigned(nanos % 1000));
+}
+
+
+int dump() {
+    if (!active) {
+        return -1;
+    }
+
+    // 先写入临时文件再改名，读取方不会看到写了一半的文件。
+    string tmpPath = outputPath + ".tmp";
+    FILE* f = fopen(tmpPath.c_str(), "w");
+    if (f == nullptr) {
+        LOG_ERROR("failed to open trace file ", tmpPath, ": ", strerror(errno));
+        return -1;
+    }
+
+    pid_t pid = getpid();
+    size_t count = 0;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(
+        f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"vesper-launcher\"}}",
+        pid
+    );
+
+    lock_guard<mutex> lock(registryLock);
+    for (auto& buffer : registry) {
+        uint64_t written = buffer->written.load(memory_order_acquire);
+        uint64_t first = written > BUFFER_EVENTS ? written - BUFFER_EVENTS : 0;
+
+        for (uint64_t i = first; i < written; i++) {
+            const Event& e = buffer->events[i % BUFFER_EVENTS];
+            bool isInstant = e.duration == UINT64_MAX;
+
+            fprintf(
+                f, ",\n{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":",
+                e.category, e.name, isInstant ? "i" : "X", pid, buffer->tid
+            );
+            printMicros(f, e.begin);
+
+            if (isInstant) {
+                fprintf(f, ",\"s\":\"t\"");
+            } else {
+                fprintf(f, ",\"dur\":");
+                printMicros(f, e.duration);
+            }
+
+            if (e.request) {
+                fprintf(f, ",\"args\":{\"request\":%" PRIu64 "}", e.request);
+            }
+
+            fprintf(f, "}");
+            count++;
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+
+    bool failed = ferror(f);
+    if (fclose(f) != 0 || failed || rename(tmpPath.c_str(), outputPath.c_str()) < 0) {
+        LOG_ERROR("failed to write trace file ", outputPath, ": ", strerror(errno));
+        unlink(tmpPath.c_str());
+        return -1;
+    }
+
+    LOG_INFO("wrote ", count, " trace events to ", outputPath);
+
+    return 0;
+}
+
+} // namespace trace
+} // namespace vl
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 请求处理过程的耗时追踪
+ *
+ * 启用后，各处理阶段作为 span 记录到所在线程的环形缓冲中，
+ * 收到 SIGUSR1 或进程退出时，以 Chrome trace event 格式（JSON）写入文件，
+ * 可用 chrome://tracing 或 Perfetto 打开。
+ *
+ * 未启用时，每个 span 只多一次全局变量的判断。
+ *
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <time.h>
+
+namespace vl {
+namespace trace {
+
+/** 每个线程最多保留的事件数。写满后覆盖最旧的事件。 */
+constexpr size_t BUFFER_EVENTS = 64 * 1024;
+
+/** 不要直接修改。使用 enable()。 */
+extern bool active;
+
+inline bool enabled() {
+    return active;
+}
+
+/**
+ * 开始记录。进程退出时自动写出到 path。
+ *
+ * @return 成功时返回 0。
+ */
+int enable(const std::string& path);
+
+/**
+ * 把各线程已记录的事件写入 enable() 指定的文件。不会清空缓冲。
+ *
+ * @return 成功时返回 0。
+ */
+int dump();
+
+/**
+ * CLOCK_MONOTONIC 当前时刻。单位为纳秒。
+ */
+inline uint64_t now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * 设置当前线程正在处理的请求编号。之后记录的事件都带有该编号，为 0 时不带。
+ */
+void setRequest(uint64_t id);
+
+/**
+ * 记录一个 [begin, end] 的 span。
+ * category 与 name 需为静态字符串，记录时只保存指针。
+ */
+void complete(const char* category, const char* name, uint64_t begin, uint64_t end);
+
+/**
+ * 记录一个瞬时事件。
+ */
+void instant(const char* category, const char* name);
+
+
+/**
+ * 从构造到析构的 span。未启用时不读取时钟。
+ */
+class Span {
+public:
+    Span(const char* category, const char* name)
+        : category(category), name(name), begin(enabled() ? now() : 0) {}
+
+    ~Span() {
+        if (begin) {
+            complete(category, name, begin, now());
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator = (const Span&) = delete;
+
+protected:
+    const char* category;
+    const char* name;
+    uint64_t begin;
+};
+
+} // namespace trace
+} // namespace vl
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * cmake config file
+ * 创建于 2024年2月25日 京沪高铁上
+ * 
+ * 不要直接修改 config.cpp 那个文件。
+ * config.cpp.in 修改后，运行 make 命令，会自动更新 config.h
+ */
+
+#include "./config.h"
+using namespace std;
+
+// vesper launcher 版本号
+const string VESPER_LAUNCHER_VERSION_NAME = "1.0.4";
+const int64_t VESPER_LAUNCHER_VERSION_MAJOR = 1;
+const int64_t VESPER_LAUNCHER_VERSION_MINOR = 0;
+const int64_t VESPER_LAUNCHER_VERSION_PATCH = 4;
+const int64_t VESPER_LAUNCHER_VERSION_CODE = 5;
+
+/** example: 2024-04-21T06:00:52Z */
+const string VESPER_LAUNCHER_BUILD_TIME_ISO8601 = "2026-10-17T09:16:49Z";
+
+/** example: April 21, 2024 14:00:52 CST */
+const string VESPER_LAUNCHER_BUILD_TIME_HUMAN_READABLE = "October 17, 2026 09:16:49 %Z";
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 检测 vesper control 是否正在运行
+ * 创建于 2026年10月17日
+ */
+
+#include "./VesperProbe.h"
+#include "../Log.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+
+using namespace std;
+
+namespace vl {
+namespace control {
+
+/** vesper 进程的 comm。 */
+static const char* VESPER_COMM = "vesper";
+
+
+/**
+ * 尝试连接控制 socket。
+ *
+ * @return 连接成功时返回 1，确定没有运行时返回 0，无法判断时返回 -1。
+ */
+static int probeSocket(const string& sockPath, pid_t& pid) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (sockPath.length() >= sizeof(addr.sun_path)) {
+        LOG_WARN("vesper control socket path too long: ", sockPath);
+        return -1;
+    }
+    strcpy(addr.sun_path, sockPath.c_str());
+    socklen_t size = offsetof(sockaddr_un, sun_path) + sockPath.length();
+
+    // 非阻塞连接：监听方的 backlog 已满时立即返回 EAGAIN，而不是等待。
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int res = -1;
+    if (connect(fd, (sockaddr*) &addr, size) == 0) {
+        ucred cred;
+        socklen_t len = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) {
+            pid = cred.pid;
+        }
+        res = 1;
+    } else if (errno == ENOENT || errno == ECONNREFUSED || errno == ENOTDIR) {
+        // socket 文件不存在，或是上次运行留下的、已经没有进程监听的文件。
+        res = 0;
+    } else if (errno == EAGAIN) {
+        // backlog 已满，说明有进程在监听，但拿不到 pid。
+        res = 1;
+    }
+
+    close(fd);
+    return res;
+}
+
+
+/**
+ * 读取 /proc/<pid>/comm，与 comm 比较。
+ */
+static bool commMatches(int procFd, const char* pidName, const char* comm) {
+    char path[64];
+    snprintf(path, sizeof(path), "%s/comm", pidName);
+
+    int fd = openat(procFd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    // comm 最长 15 个字符，以换行结尾。
+    char buf[32];
+    ssize_t n = read(fd, buf, sizeof(buf));
+    close(fd);
+
+    size_t len = strlen(comm);
+    return n == ssize_t(len + 1) && memcmp(buf, comm, len) == 0 && buf[len] == '\n';
+}
+
+
+pid_t findProcess(uid_t uid, const char* comm) {
+    int procFd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0) {
+        LOG_WARN("failed to open /proc: ", strerror(errno));
+        return 0;
+    }
+
+    // linux_dirent64。glibc 没有导出该结构体，按内核的布局解析。
+    struct Dirent64 {
+        ino64_t ino;
+        off64_t off;
+        unsigned short reclen;
+        unsigned char type;
+        char name[];
+    };
+
+    alignas(Dirent64) char buf[32 * 1024];
+    pid_t self = getpid();
+    pid_t found = 0;
+
+    while (!found) {
+        long n = syscall(SYS_getdents64, procFd, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0) {
+                LOG_WARN("failed to read /proc: ", strerror(errno));
+            }
+            break;
+        }
+
+        for (long offset = 0; offset < n && !found; ) {
+            auto* ent = (Dirent64*) (buf + offset);
+            offset += ent->reclen;
+
+            // 只看 /proc/<pid> 目录。
+            if (ent->type != DT_DIR || ent->name[0] < '1' || ent->name[0] > '9') {
+                continue;
+            }
+
+            // /proc/<pid> 的属主是进程的 euid。
+            struct stat st;
+            if (fstatat(procFd, ent->name, &st, 0) < 0 || st.st_uid != uid) {
+                continue;
+            }
+
+            pid_t pid = pid_t(atoi(ent->name));
+            if (pid != self && commMatches(procFd, ent->name, comm)) {
+                found = pid;
+            }
+        }
+    }
+
+    close(procFd);
+    return found;
+}
+
+
+ProbeResult probeVesperControl(const string& sockPath) {
+    ProbeResult result;
+
+    pid_t pid = 0;
+    int res = probeSocket(sockPath, pid);
+
+    if (res == 1) {
+        result.live = true;
+        result.pid = pid;
+        result.source = ProbeResult::Source::SOCKET;
+    } else if (res < 0) {
+        pid = findProcess(geteuid(), VESPER_COMM);
+        if (pid > 0) {
+            result.live = true;
+            result.pid = pid;
+            result.source = ProbeResult::Source::PROC;
+        }
+    }
+
+    return result;
+}
+
+} // namespace control
+} // namespace vl
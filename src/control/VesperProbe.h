@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 检测 vesper control 是否正在运行
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <string>
+
+#include <sys/types.h>
+
+namespace vl {
+namespace control {
+
+struct ProbeResult {
+    enum class Source {
+        /** 未检测到。 */
+        NONE,
+
+        /** 控制 socket 接受了连接。 */
+        SOCKET,
+
+        /** 在 /proc 中找到了进程。 */
+        PROC,
+    };
+
+    bool live = false;
+
+    /** 检测到的 vesper 进程。无法得知时为 0。 */
+    pid_t pid = 0;
+
+    Source source = Source::NONE;
+};
+
+
+/**
+ * 检测 vesper control 是否正在运行。不创建子进程。
+ *
+ * 先尝试 connect() 控制 socket：
+ * - 连接成功：正在运行，pid 由 SO_PEERCRED 给出；
+ * - socket 文件不存在，或没有进程在监听（ECONNREFUSED）：没有运行；
+ * - 其他情况（如无权连接、socket 类型不符）无法判断，改为扫描一遍 /proc，
+ *   查找 euid 与本进程相同、comm 为 vesper 的进程。
+ *
+ * @param sockPath 控制 socket 的完整路径。
+ */
+ProbeResult probeVesperControl(const std::string& sockPath);
+
+
+/**
+ * 扫描 /proc，查找 euid 为 uid、comm 为 comm 的进程。
+ * 只读取一遍 /proc 目录（getdents64），仅对 uid 匹配的进程读取 comm。
+ *
+ * @return 找到的第一个进程的 pid。没有找到时返回 0。
+ */
+pid_t findProcess(uid_t uid, const char* comm);
+
+} // namespace control
+} // namespace vl
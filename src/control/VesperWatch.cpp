@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 监视 vesper control socket 的出现与消失
+ * 创建于 2026年10月17日
+ */
+
+#include "./VesperWatch.h"
+#include "./VesperProbe.h"
+#include "../Log.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/inotify.h>
+
+using namespace std;
+
+namespace vl {
+namespace control {
+
+VesperWatch::~VesperWatch() {
+    shutdown();
+}
+
+
+int VesperWatch::init(const string& sockPath, Callback callback) {
+    this->sockPath = sockPath;
+    this->callback = callback;
+
+    string dir = ".";
+    sockName = sockPath;
+    auto slash = sockPath.rfind('/');
+    if (slash != string::npos) {
+        dir = slash == 0 ? "/" : sockPath.substr(0, slash);
+        sockName = sockPath.substr(slash + 1);
+    }
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        LOG_ERROR("failed to create inotify instance: ", strerror(errno));
+        return -1;
+    }
+
+    uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+    if (inotify_add_watch(inotifyFd, dir.c_str(), mask) < 0) {
+        LOG_ERROR("failed to watch ", dir, ": ", strerror(errno));
+        close(inotifyFd);
+        inotifyFd = -1;
+        return -2;
+    }
+
+    // 先开始监视再检测，检测期间发生的变化会留在事件队列中。
+    isLive = probe();
+    return 0;
+}
+
+
+bool VesperWatch::probe() const {
+    auto result = probeVesperControl(sockPath);
+    if (result.live && result.pid > 0) {
+        LOG_INFO("vesper control pid: ", result.pid);
+    }
+
+    return result.live;
+}
+
+
+void VesperWatch::onReadable() {
+    alignas(inotify_event) char buf[4096];
+    bool live = isLive;
+
+    while (true) {
+        ssize_t n = read(inotifyFd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno != EAGAIN) {
+                LOG_WARN("failed to read inotify events: ", strerror(errno));
+            }
+
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < n; ) {
+            auto* event = (inotify_event*) (buf + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                live = probe();
+            } else if (event->mask & IN_IGNORED) {
+                LOG_WARN("directory of vesper control socket is gone. stopped watching.");
+            } else if (event->len && sockName == event->name) {
+                live = (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0;
+            }
+        }
+    }
+
+    if (live != isLive) {
+        isLive = live;
+        callback(live);
+    }
+}
+
+
+void VesperWatch::shutdown() {
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+}
+
+} // namespace control
+} // namespace vl
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 监视 vesper control socket 的出现与消失
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace vl {
+namespace control {
+
+/**
+ * 用 inotify 监视 vesper control socket 所在的目录。不轮询，空闲时不占用 CPU。
+ *
+ * socket 被创建（vesper bind）或移入时，视为 vesper control 开始运行；被删除或移出时，视为已经退出。
+ * 启动时的状态由 probeVesperControl() 确定，因此上次运行留下的 socket 文件不会被误认。
+ * vesper control 异常退出且未删除 socket 时无法察觉，直到该文件被删除或重新创建。
+ *
+ * 调用者需要在 fd() 可读时调用 onReadable()。
+ */
+class VesperWatch {
+public:
+    /**
+     * @param live vesper control 是否正在运行。
+     */
+    using Callback = std::function<void (bool live)>;
+
+    VesperWatch() {}
+    ~VesperWatch();
+
+    VesperWatch(const VesperWatch&) = delete;
+    VesperWatch& operator = (const VesperWatch&) = delete;
+
+    /**
+     * 开始监视，并检测当前状态。不会为初始状态调用 callback。
+     *
+     * @param sockPath 控制 socket 的完整路径。
+     * @return 成功时返回 0。
+     */
+    int init(const std::string& sockPath, Callback callback);
+
+    bool enabled() const { return inotifyFd >= 0; }
+
+    /**
+     * inotify 描述符。未启用时为 -1。
+     */
+    int fd() const { return inotifyFd; }
+
+    bool live() const { return isLive; }
+
+    /**
+     * 处理积压的 inotify 事件。状态变化时调用 callback。
+     * 一批事件只按最终状态回调一次，vesper 重启（删除后重新创建 socket）不会引起来回切换。
+     */
+    void onReadable();
+
+    void shutdown();
+
+protected:
+    /** 重新检测状态。用于事件队列溢出后。 */
+    bool probe() const;
+
+    std::string sockPath;
+
+    /** socket 所在目录中的文件名。 */
+    std::string sockName;
+
+    Callback callback;
+
+    int inotifyFd = -1;
+    bool isLive = false;
+};
+
+} // namespace control
+} // namespace vl
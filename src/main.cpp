@@ -5,6 +5,8 @@
  * 创建于 2024年2月25日 京沪高铁上
  */
 
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <map>
@@ -15,8 +17,12 @@
 #include <unistd.h>
 
 #include "./Log.h"
+#include "./Trace.h"
 #include "./config.h"
 #include "./Protocols.h"
+#include "./server/SocketServer.h"
+#include "./spawn/Spawner.h"
+#include "./control/VesperProbe.h"
 
 #include <fcntl.h>
 #include <signal.h>
@@ -26,8 +32,6 @@
 #include <sys/un.h>
 #include <sys/stat.h>
 
-#include <filesystem>
-
 using namespace std;
 
 
@@ -47,18 +51,40 @@ static struct {
     } environment;
 
     string domainSocket;
+    int listenBacklog;
+    string ioBackend;
+    string spawnStrategy;
+    bool zygote;
+
+    string prewarmCmd;
+    int prewarmCount;
+    int prewarmRefillDelay;
+    bool prewarmPark;
+    bool keepAlive;
+    size_t maxFrameSize;
+
+    string captureLogs;  // 相对 $XDG_RUNTIME_DIR
+    size_t captureLogSize;
+    int captureLogSegments;
+    int captureLogSessions;
+
+    int logLevel;
+    bool logJson;
+
+    string traceFile;  // 相对 $XDG_RUNTIME_DIR
+    string recordFrames;  // 相对 $XDG_RUNTIME_DIR
 
     bool daemonize;
     bool serviceMode;
     bool waitForChildBeforeExit;
 
     bool quitIfVesperCtrlLive;
+    string watchVesperCtrl;  // 为空时不监视
     string vesperCtrlSockAddr;  // 相对 $XDG_RUNTIME_DIR
 } config;
 
 
-static bool systemRunning;
-static int socketListenFd = -1;
+static vl::server::SocketServer socketServer;
 
 /* ------------ "一句话"指令 ------------ */
 
@@ -103,11 +129,30 @@ static void loadPredefinedArgKeys() {
         { "--usage", true },
         { "--help", true },
         { "--domain-socket", false },
+        { "--listen-backlog", false },
+        { "--io-backend", false },
+        { "--spawn-strategy", false },
+        { "--zygote", true },
+        { "--prewarm", false },
+        { "--prewarm-count", false },
+        { "--prewarm-refill-delay", false },
+        { "--prewarm-mode", false },
+        { "--keep-alive", true },
+        { "--max-frame-size", false },
+        { "--capture-logs", false },
+        { "--capture-log-size", false },
+        { "--capture-log-segments", false },
+        { "--capture-log-sessions", false },
         { "--daemonize", true },
         { "--service-mode", true },
         { "--wait-for-child-before-exit", true },
         { "--no-color", true },
+        { "--log-level", false },
+        { "--log-format", false },
+        { "--trace", false },
+        { "--record-frames", false },
         { "--quit-if-vesper-ctrl-live", true },
+        { "--watch-vesper-ctrl", false },
         { "--vesper-ctrl-sock-addr", false }
     };
 
@@ -220,16 +265,36 @@ static int daemonize() {
     chdir("~");
 
     signal(SIGTERM, [] (int arg) {
-        systemRunning = false;
-        if (socketListenFd != -1) {
-            shutdown(socketListenFd, SHUT_RDWR);
-        }
+        socketServer.stop();
     });
 
     return 0;
 }
 
 
+/**
+ * 读取数值型命令行参数。参数未设置时，保持 value 不变。
+ *
+ * @return 参数格式错误或超出 [minValue, maxValue] 时返回负数。
+ */
+static int readIntArg(const string& key, int64_t minValue, int64_t maxValue, int64_t& value) {
+    if (!userArgs.variables.contains(key)) {
+        return 0;
+    }
+
+    const string& str = userArgs.variables[key];
+    char* end = nullptr;
+    long long res = strtoll(str.c_str(), &end, 10);
+    if (str.empty() || *end != '\0' || res < minValue || res > maxValue) {
+        cout << "error: invalid " << key << ": " << str << endl;
+        return -1;
+    }
+
+    value = res;
+    return 0;
+}
+
+
 static int buildConfig() {
     if (!envVars.contains("XDG_RUNTIME_DIR")) {
         cout << "error: XDG_RUNTIME_DIR required but not set." << endl;
@@ -247,239 +312,200 @@ static int buildConfig() {
         config.domainSocket = userArgs.variables["--domain-socket"];
     }
 
-    config.daemonize = userArgs.flags.contains("--daemonize");
-    config.serviceMode = userArgs.flags.contains("--service-mode");
-    config.waitForChildBeforeExit = userArgs.flags.contains("--wait-for-child-before-exit");
-    config.quitIfVesperCtrlLive = userArgs.flags.contains("--quit-if-vesper-ctrl-live");
-
-    if (config.quitIfVesperCtrlLive) {
-        const string vesperCtrlSockAddrCmdlineKey = "--vesper-ctrl-sock-addr";
-        if (!userArgs.variables.contains(vesperCtrlSockAddrCmdlineKey)) {
-            cout << "--quit-if-vesper-ctrl-live should be paired with " 
-                << vesperCtrlSockAddrCmdlineKey << endl;
-            return -4;
-        }
-
-        config.vesperCtrlSockAddr = userArgs.variables[vesperCtrlSockAddrCmdlineKey];
+    int64_t listenBacklog = 64;
+    if (readIntArg("--listen-backlog", 1, INT32_MAX, listenBacklog)) {
+        return -5;
     }
+    config.listenBacklog = int(listenBacklog);
 
-    if (config.daemonize && config.serviceMode) {
-        cout << "--daemonize and --service-mode should not come together. confusing!" << endl;
-        return -3;
+    int64_t maxFrameSize = vl::server::FrameDecoder::DEFAULT_MAX_FRAME_SIZE;
+    if (readIntArg("--max-frame-size", 0, INT32_MAX - vl::protocol::HEADER_LEN, maxFrameSize)) {
+        return -7;
     }
-    
-    return 0;
-}
-
-
-/* ------------ 网络 ------------ */
-
-static void sendResponse(int connFd, uint32_t code, const string& msg) {
-    vl::protocol::Response response;
-    response.code = code;
-    response.msg = msg;
-    
-    stringstream s(ios::in | ios::out | ios::binary);
-    response.encode(s);
-
-    string str = s.str();
-    write(connFd, str.c_str(), str.length());
-}
-
-
-/**
- * 
- * 
- * 
- * @return 异常退出时，返回负数；
- *         正常退出时，如果希望结束监听，不再服务下一个 client，返回0；否则返回正数。
- */
-static int processProtocol(vl::protocol::Base* protocol, int connFd) {
-    auto protocolType = protocol->getType();
-    
-    if (protocolType == vl::protocol::ShellLaunch::typeCode) {
-        auto* p = (vl::protocol::ShellLaunch*) protocol;
-        pid_t pid = fork();
-        if (pid < 0) {
-            const char* errMsg = "failed to create subprocess!";
-            LOG_ERROR(errMsg);
-            sendResponse(connFd, 1, errMsg);
-            return 1;
-        } else if (pid == 0) { // new process
-            execl("/bin/sh", "/bin/sh", "-c", p->cmd.c_str(), nullptr);
-            exit(-1);
+    config.maxFrameSize = size_t(maxFrameSize);
+
+    config.ioBackend = "epoll";
+    if (userArgs.variables.contains("--io-backend")) {
+        config.ioBackend = userArgs.variables["--io-backend"];
+        if (config.ioBackend != "epoll" && config.ioBackend != "io-uring") {
+            cout << "error: --io-backend should be \"epoll\" or \"io-uring\"." << endl;
+            return -6;
         }
-
-        sendResponse(connFd, 0, "");
-
-        return 0;
-    } else {
-        LOG_ERROR("type unrecognized: ", protocol->getType());
-        return 1;
     }
-}
 
-static int readNBytesFromSocket(int connFd, int n, char* buf) {
-    int totalBytesRead = 0;
-    char* dataPtr = buf;
-    while (totalBytesRead < n) {
-        int bytes = read(connFd, dataPtr, n - totalBytesRead);
-        if (bytes < 0) {
-            LOG_ERROR("read error! nBytes is ", n);
-            return -2;
-        } else if (bytes == 0) {
-            LOG_ERROR("unexpected EOF from socket.");
-            return -3;
+    config.spawnStrategy = "posix-spawn";
+    if (userArgs.variables.contains("--spawn-strategy")) {
+        config.spawnStrategy = userArgs.variables["--spawn-strategy"];
+        if (vl::spawn::createSpawner(config.spawnStrategy) == nullptr) {
+            cout << "error: --spawn-strategy should be one of "
+                << "\"posix-spawn\", \"vfork\", \"clone\", \"fork\" and \"stub\"." << endl;
+            return -8;
         }
-
-        totalBytesRead += bytes;
-        dataPtr += bytes;
     }
 
-    return 0;
-}
-
-
-/**
- * 
- * 
- * 
- * @return 异常退出时，返回负数；
- *         正常退出时，如果希望结束监听，返回0；否则返回正数。
- */
-static int acceptClient(int listenFd, vector<char>& bufContainer) {
-
-    sockaddr_un client;
-    socklen_t clientLen = sizeof(client);
+    if (userArgs.variables.contains("--prewarm")) {
+        config.prewarmCmd = userArgs.variables["--prewarm"];
+    }
 
-    int connFd = accept(listenFd, (sockaddr*) &client, &clientLen);
-    if (connFd < 0) {
+    int64_t prewarmCount = 1;
+    if (readIntArg("--prewarm-count", 1, 64, prewarmCount)) {
+        return -9;
+    }
+    config.prewarmCount = int(prewarmCount);
 
-        if (!systemRunning) {
-            return 0;
+    int64_t prewarmRefillDelay = 0;
+    if (readIntArg("--prewarm-refill-delay", -1, INT32_MAX, prewarmRefillDelay)) {
+        return -9;
+    }
+    config.prewarmRefillDelay = int(prewarmRefillDelay);
+
+    config.prewarmPark = false;
+    if (userArgs.variables.contains("--prewarm-mode")) {
+        const string& mode = userArgs.variables["--prewarm-mode"];
+        if (mode != "stop" && mode != "park") {
+            cout << "error: --prewarm-mode should be \"stop\" or \"park\"." << endl;
+            return -9;
         }
-
-        LOG_WARN("socket connection failed.");
-        return 1;
+        config.prewarmPark = mode == "park";
     }
 
-    int resCode = 0;
-    do {
+    if (userArgs.variables.contains("--capture-logs")) {
+        config.captureLogs = userArgs.variables["--capture-logs"];
+    }
 
-        auto dataPtr = bufContainer.data();
+    int64_t captureLogSize = 1024 * 1024;
+    if (readIntArg("--capture-log-size", 4096, INT64_MAX, captureLogSize)) {
+        return -10;
+    }
+    config.captureLogSize = size_t(captureLogSize);
 
-        // 读入 header
+    int64_t captureLogSegments = 4;
+    if (readIntArg("--capture-log-segments", 1, 64, captureLogSegments)) {
+        return -10;
+    }
+    config.captureLogSegments = int(captureLogSegments);
 
-        if (readNBytesFromSocket(connFd, vl::protocol::HEADER_LEN, dataPtr)) {
-            const char* err = "failed to read header!";
-            LOG_ERROR(err);
-            sendResponse(connFd, 2, err);
-            resCode = 2;
-            break;
+    int64_t captureLogSessions = 64;
+    if (readIntArg("--capture-log-sessions", 1, 65536, captureLogSessions)) {
+        return -10;
+    }
+    config.captureLogSessions = int(captureLogSessions);
+
+    config.logLevel = vl::log::LEVEL_INFO;
+    if (userArgs.variables.contains("--log-level")) {
+        config.logLevel = vl::log::parseLevel(userArgs.variables["--log-level"]);
+        if (config.logLevel < 0) {
+            cout << "error: --log-level should be one of "
+                << "\"debug\", \"info\", \"warn\", \"error\" and \"off\"." << endl;
+            return -11;
         }
+    }
 
-        if (strncmp(dataPtr, vl::protocol::MAGIC_STR, 4)) {
-            const char* err = "magic mismatched!";
-            LOG_ERROR(err);
-            sendResponse(connFd, 3, err);
-            resCode = 3;
-            break;
+    config.logJson = false;
+    if (userArgs.variables.contains("--log-format")) {
+        const string& format = userArgs.variables["--log-format"];
+        if (format != "text" && format != "json") {
+            cout << "error: --log-format should be \"text\" or \"json\"." << endl;
+            return -11;
         }
-        dataPtr += 4;
-
-        uint32_t type = be32toh(*(uint32_t*) dataPtr);
-        dataPtr += 4;
+        config.logJson = format == "json";
+    }
 
-        uint64_t length = be64toh(*(uint64_t*) dataPtr);
-        dataPtr += 8;
+    if (userArgs.variables.contains("--trace")) {
+        config.traceFile = userArgs.variables["--trace"];
+    }
 
-        if (length + vl::protocol::HEADER_LEN > bufContainer.capacity())
-            bufContainer.reserve(length + vl::protocol::HEADER_LEN);
+    if (userArgs.variables.contains("--record-frames")) {
+        config.recordFrames = userArgs.variables["--record-frames"];
+    }
 
-        dataPtr = bufContainer.data();
+    config.keepAlive = userArgs.flags.contains("--keep-alive");
+    config.zygote = userArgs.flags.contains("--zygote");
+    config.daemonize = userArgs.flags.contains("--daemonize");
+    config.serviceMode = userArgs.flags.contains("--service-mode");
+    config.waitForChildBeforeExit = userArgs.flags.contains("--wait-for-child-before-exit");
+    config.quitIfVesperCtrlLive = userArgs.flags.contains("--quit-if-vesper-ctrl-live");
 
-        if (readNBytesFromSocket(connFd, length, dataPtr + vl::protocol::HEADER_LEN)) {
-            const char* err = "failed to read body!";
-            LOG_ERROR(err);
-            sendResponse(connFd, 5, err);
-            resCode = 5;
-            break;
-        }
-    
-        vl::protocol::Base* protocol = vl::protocol::decode(dataPtr, type, length + vl::protocol::HEADER_LEN);
-
-        if (protocol == nullptr) {
-            const char* err = "failed to parse protocol!";
-            LOG_ERROR(err);
-            sendResponse(connFd, 7, err);
-            resCode = 6;
-            break;
+    if (userArgs.variables.contains("--watch-vesper-ctrl")) {
+        config.watchVesperCtrl = userArgs.variables["--watch-vesper-ctrl"];
+        if (config.watchVesperCtrl != "exit" && config.watchVesperCtrl != "standby") {
+            cout << "error: --watch-vesper-ctrl should be \"exit\" or \"standby\"." << endl;
+            return -13;
         }
+    }
 
-        resCode = processProtocol(protocol, connFd);
+    if (config.quitIfVesperCtrlLive || !config.watchVesperCtrl.empty()) {
+        const string vesperCtrlSockAddrCmdlineKey = "--vesper-ctrl-sock-addr";
+        if (!userArgs.variables.contains(vesperCtrlSockAddrCmdlineKey)) {
+            cout << (config.quitIfVesperCtrlLive ? "--quit-if-vesper-ctrl-live" : "--watch-vesper-ctrl")
+                << " should be paired with " 
+                << vesperCtrlSockAddrCmdlineKey << endl;
+            return -4;
+        }
 
-    } while (0); // end of do-while(0)
+        config.vesperCtrlSockAddr = userArgs.variables[vesperCtrlSockAddrCmdlineKey];
+    }
 
-    close(connFd);
-    return resCode;
+    if (config.daemonize && config.serviceMode) {
+        cout << "--daemonize and --service-mode should not come together. confusing!" << endl;
+        return -3;
+    }
+    
+    return 0;
 }
 
 
-struct AutoClose {
-    int fd;
-    AutoClose(int fd) {
-        this->fd = fd;
-    }
-    ~AutoClose() {
-        close(fd);
-    }
-};
+/* ------------ 网络 ------------ */
 
 static int runSocketServer() {
-    vector<char> bufContainer { vl::protocol::HEADER_LEN };
-
-    string socketAddr = config.environment.xdgRuntimeDir;
-    socketAddr += "/";
-    socketAddr += config.domainSocket;
-
-    int listenFd;
-    if ( (listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ) {
-        LOG_ERROR("failed to create domain socket at: ", socketAddr);
-        return -1;
+    vl::server::SocketServer::Options options;
+
+    options.socketAddr = config.environment.xdgRuntimeDir;
+    options.socketAddr += "/";
+    options.socketAddr += config.domainSocket;
+
+    options.listenBacklog = config.listenBacklog;
+    options.ioBackend = config.ioBackend;
+    options.spawnStrategy = config.spawnStrategy;
+    options.zygote = config.zygote;
+
+    options.prewarm.cmd = config.prewarmCmd;
+    options.prewarm.size = config.prewarmCount;
+    options.prewarm.refillDelayMs = config.prewarmRefillDelay;
+    options.prewarm.mode = config.prewarmPark
+        ? vl::spawn::PrewarmPool::Mode::PARK : vl::spawn::PrewarmPool::Mode::STOP;
+    options.keepAlive = config.keepAlive;
+    options.maxFrameSize = config.maxFrameSize;
+
+    if (!config.captureLogs.empty()) {
+        options.logCaptureDir = config.environment.xdgRuntimeDir;
+        options.logCaptureDir += "/";
+        options.logCaptureDir += config.captureLogs;
     }
-
-
-    sockaddr_un server;
-
-    memset(&server, 0, sizeof(server));
-    server.sun_family = AF_UNIX;
-    strcpy(server.sun_path, socketAddr.c_str());
-    unlink(socketAddr.c_str());
-
-    int size = offsetof(sockaddr_un, sun_path) + socketAddr.length();
-
-    if ( bind(listenFd, (sockaddr*) &server, size) < 0 ) {
-        LOG_ERROR("failed to bind domain socket: ", socketAddr);
-        close(listenFd);
-        return -1;
+    options.logCapture.maxSize = config.captureLogSize;
+    options.logCapture.segments = config.captureLogSegments;
+    options.logCaptureSessions = config.captureLogSessions;
+
+    if (!config.recordFrames.empty()) {
+        options.recordFile = config.environment.xdgRuntimeDir;
+        options.recordFile += "/";
+        options.recordFile += config.recordFrames;
     }
-    
-    if ( listen(listenFd, 1) < 0 ) {
-        LOG_ERROR("failed to listen domain socket: ", socketAddr);
-        close(listenFd);
-        return -1;
+
+    if (!config.watchVesperCtrl.empty()) {
+        options.vesperCtrlSock = config.environment.xdgRuntimeDir;
+        options.vesperCtrlSock += "/";
+        options.vesperCtrlSock += config.vesperCtrlSockAddr;
     }
+    options.exitOnVesperCtrl = config.watchVesperCtrl == "exit";
 
-    systemRunning = true;
-    socketListenFd = listenFd;
-    int res;
-    while ( (res = acceptClient(listenFd, bufContainer)) > 0 )
-        ;
+    socketServer.prepare(options);
 
+    // 之后的日志由后台线程写出，不再阻塞事件循环。
+    // 写出线程在 zygote fork 出来之后才启动。
+    vl::log::startAsync();
 
-    close(listenFd);
-    unlink(socketAddr.c_str());
-    return res;
+    return socketServer.run();
 }
 
 
@@ -488,30 +514,20 @@ bool vesperControlLive() {
     sockAddr += '/';
     sockAddr += config.vesperCtrlSockAddr;
 
-    if (!filesystem::exists(sockAddr)) {
-        return false;  // vesper ctrl socket not detected.
+    auto probe = vl::control::probeVesperControl(sockAddr);
+    if (!probe.live) {
+        return false;
     }
 
+    if (probe.pid > 0) {
+        LOG_INFO("vesper control live (pid ", probe.pid, ", detected via ",
+            probe.source == vl::control::ProbeResult::Source::SOCKET ? "socket" : "/proc",
+            ").");
+    } else {
+        LOG_INFO("vesper control live (pid unknown).");
+    }
 
-    // now, we should check whether vesper process presents.
-
-    // note that if vesper quit unexpectly and new instance of vesper
-    // launched without enabling vesper ctrl, this function would still
-    // return true.
-
-    string cmd = "pgrep";
-    cmd += " -x -u ";
-    cmd += to_string(geteuid());
-    cmd += " ";
-    cmd += "vesper";
-    
-    FILE* cmdPipe = popen(cmd.c_str(), "r");
-    char buf[4];
-    buf[0] = '\0';
-    fgets(buf, sizeof(buf), cmdPipe);
-    pclose(cmdPipe);
-
-    return buf[0] != '\0';
+    return true;
 }
 
 
@@ -537,7 +553,11 @@ int main(int argc, const char* argv[], const char* env[]) {
         return -1;
     }
 
-    if (config.quitIfVesperCtrlLive) {
+    vl::log::setLevel(config.logLevel);
+    vl::log::setFormat(config.logJson ? vl::log::Format::JSON : vl::log::Format::TEXT);
+
+    // standby 模式下，由服务端在 vesper control 退出后开始服务。
+    if (config.quitIfVesperCtrlLive || config.watchVesperCtrl == "exit") {
         if (vesperControlLive()) {
             return 0;  // vesper ctrl detected. quit.
         }
@@ -547,6 +567,16 @@ int main(int argc, const char* argv[], const char* env[]) {
         daemonize();
     }
 
+    // 在 daemonize 之后开启，父进程退出时不会写出空的 trace。
+    if (!config.traceFile.empty()) {
+        string path = config.environment.xdgRuntimeDir;
+        path += "/";
+        path += config.traceFile;
+        if (vl::trace::enable(path)) {
+            return -12;
+        }
+    }
+
     if (config.serviceMode) {
         cout << "error: service mode is currently not supported!" << endl;
         return -1;
@@ -560,9 +590,21 @@ int main(int argc, const char* argv[], const char* env[]) {
     }
 
     if (config.waitForChildBeforeExit) {
-        int stat;
-        pid_t pid = wait(&stat);
-        LOG_INFO("pid ", pid, " exited, with stat: ", stat);
+        // 只等待启动的程序：服务期间退出的已被回收，过继来的孤儿进程也不应被等到。
+        auto& child = socketServer.firstLaunchedChild();
+        pid_t pid = child.pid;
+        int stat = child.status;
+        if (pid > 0 && !child.exited) {
+            while ((pid = waitpid(child.pid, &stat, 0)) < 0 && errno == EINTR) {}
+        }
+
+        if (pid > 0) {
+            LOG_INFO_KV("child exited.", "pid", pid, "stat", stat);
+        } else if (child.pid == 0) {
+            LOG_INFO("no child was launched.");
+        } else {
+            LOG_WARN("failed to wait for pid ", child.pid, ": ", strerror(errno));
+        }
     }
 
     LOG_INFO("vesper-launcher exited successfully.");
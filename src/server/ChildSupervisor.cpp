@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 子进程监管
+ * 创建于 2026年10月17日
+ */
+
+#include "./ChildSupervisor.h"
+#include "../Log.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+ChildSupervisor::~ChildSupervisor() {
+    shutdown();
+}
+
+
+int ChildSupervisor::init(EventLoop& loop, ExitCallback onExit, bool subreaper) {
+    this->loop = &loop;
+    this->onExit = onExit;
+
+    if (subreaper && prctl(PR_SET_CHILD_SUBREAPER, 1) < 0) {
+        LOG_WARN("failed to become child subreaper: ", strerror(errno));
+    }
+
+    // 屏蔽 SIGCHLD，改由 signalfd 接收。各 spawn 策略会在子进程中清空信号掩码。
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0) {
+        LOG_ERROR("failed to create signalfd: ", strerror(errno));
+        return -1;
+    }
+
+    loop.add(signalFd, EPOLLIN, [this] (uint32_t) {
+        // 多个 SIGCHLD 可能合并为一个，读空后统一回收。
+        signalfd_siginfo info;
+        while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {}
+        reap();
+    });
+
+    // 启动前可能已有子进程退出。
+    reap();
+
+    return 0;
+}
+
+
+void ChildSupervisor::track(pid_t pid, int pidfd, string_view cmd) {
+    if (loop == nullptr) {
+        if (pidfd >= 0) {
+            close(pidfd);
+        }
+        return;
+    }
+
+    if (pidfd < 0) {
+        pidfd = int(syscall(SYS_pidfd_open, pid, 0));
+        if (pidfd < 0) {
+            // 子进程已退出并被回收，或内核不支持 pidfd。由 SIGCHLD 兜底。
+            return;
+        }
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    auto& child = tracked[pid];
+    child.pid = pid;
+    child.pidfd = pidfd;
+    child.procDirFd = openProcessDir(pid);
+    child.cmd.assign(cmd);
+    child.startTime = uint64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+    child.sample = ProcessSample();
+
+    loop->add(pidfd, EPOLLIN, [this] (uint32_t) {
+        reap();
+    });
+}
+
+
+void ChildSupervisor::untrack(pid_t pid) {
+    auto it = tracked.find(pid);
+    if (it == tracked.end()) {
+        return;
+    }
+
+    auto& child = it->second;
+    loop->remove(child.pidfd);
+    close(child.pidfd);
+    if (child.procDirFd >= 0) {
+        close(child.procDirFd);
+    }
+    tracked.erase(it);
+}
+
+
+void ChildSupervisor::reap() {
+    while (true) {
+        ExitInfo info;
+        info.pid = wait4(-1, &info.status, WNOHANG, &info.usage);
+        if (info.pid <= 0) {
+            break;
+        }
+
+        info.tracked = tracked.contains(info.pid);
+        untrack(info.pid);
+
+        if (onExit) {
+            onExit(info);
+        }
+    }
+}
+
+
+const vector<const ChildSupervisor::Child*>& ChildSupervisor::snapshot() {
+    uint64_t now = monotonicMicros();
+
+    snapshotBuf.clear();
+    for (auto& it : tracked) {
+        auto& child = it.second;
+        if (child.procDirFd >= 0 && now - child.sample.sampledAt >= SAMPLE_TTL) {
+            sampleProcess(child.procDirFd, child.sample);
+        }
+        snapshotBuf.push_back(&child);
+    }
+
+    return snapshotBuf;
+}
+
+
+void ChildSupervisor::shutdown() {
+    if (loop == nullptr) {
+        return;
+    }
+
+    while (!tracked.empty()) {
+        untrack(tracked.begin()->first);
+    }
+
+    if (signalFd >= 0) {
+        loop->remove(signalFd);
+        close(signalFd);
+        signalFd = -1;
+    }
+
+    loop = nullptr;
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 子进程监管
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/resource.h>
+
+#include "./EventLoop.h"
+#include "./ProcessSampler.h"
+
+namespace vl {
+namespace server {
+
+/**
+ * 回收子进程，并报告其退出状态。
+ *
+ * launcher 启动的子进程通过 pidfd 注册到事件循环中。常驻（keep-alive）时 launcher 同时设置为
+ * child subreaper，子进程留下的孤儿进程会被过继给 launcher，这些进程没有 pidfd，通过 signalfd 接收
+ * SIGCHLD 回收。一次性运行时不设置，launcher 的子进程只有它自己创建的进程。
+ *
+ * 两种事件都会触发一次 wait4(-1) 循环，回收所有已退出的子进程。预热池实例与 zygote 也会在这里被回收，
+ * onExit 需要把它们交还给 spawn::Launcher::onChildExit()，否则其所有者会继续使用可能已被复用的 pid。
+ */
+class ChildSupervisor {
+public:
+    struct ExitInfo {
+        pid_t pid;
+
+        /** wait4 得到的原始状态。 */
+        int status;
+
+        struct rusage usage;
+
+        /** 是否是通过 track() 登记的子进程。 */
+        bool tracked;
+    };
+
+    using ExitCallback = std::function<void (const ExitInfo& info)>;
+
+    /** 登记的子进程。 */
+    struct Child {
+        pid_t pid;
+        int pidfd;
+
+        /** /proc/<pid> 目录。打开失败时为 -1。 */
+        int procDirFd;
+
+        /** 启动命令。 */
+        std::string cmd;
+
+        /** 启动时刻（CLOCK_REALTIME）。单位为微秒。 */
+        uint64_t startTime;
+
+        /** 最近一次采样。 */
+        ProcessSample sample;
+    };
+
+    /** 采样结果在该时长内有效。单位为微秒。 */
+    static const uint64_t SAMPLE_TTL = 250 * 1000;
+
+    ChildSupervisor() {}
+    ~ChildSupervisor();
+
+    ChildSupervisor(const ChildSupervisor&) = delete;
+    ChildSupervisor& operator = (const ChildSupervisor&) = delete;
+
+    /**
+     * 开始接收 SIGCHLD。此后本线程屏蔽 SIGCHLD。
+     *
+     * @param subreaper 是否设置为 child subreaper，接管子进程留下的孤儿进程。
+     * @return 成功时返回 0。
+     */
+    int init(EventLoop& loop, ExitCallback onExit, bool subreaper);
+
+    /**
+     * 登记一个子进程。
+     *
+     * @param pidfd 子进程的 pidfd，所有权转交给本对象。为 -1 时自行打开。
+     * @param cmd 启动命令。用于状态查询。
+     */
+    void track(pid_t pid, int pidfd, std::string_view cmd);
+
+    /**
+     * 获取所有登记的子进程。采样超过 SAMPLE_TTL 的子进程会被重新采样，其余直接使用缓存。
+     * 返回的指针在下一次事件循环分发前有效。
+     */
+    const std::vector<const Child*>& snapshot();
+
+    /**
+     * 停止监管。未退出的子进程保持运行。
+     */
+    void shutdown();
+
+    size_t trackedCount() const { return tracked.size(); }
+
+protected:
+    /**
+     * 回收所有已退出的子进程。
+     */
+    void reap();
+
+    void untrack(pid_t pid);
+
+    EventLoop* loop = nullptr;
+    ExitCallback onExit;
+    int signalFd = -1;
+
+    std::unordered_map<pid_t, Child> tracked;
+
+    std::vector<const Child*> snapshotBuf;
+};
+
+} // namespace server
+} // namespace vl
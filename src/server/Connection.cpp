@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 客户端连接状态
+ * 创建于 2026年10月17日
+ */
+
+#include "./Connection.h"
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+Connection::Connection(int fd) {
+    this->fd = fd;
+}
+
+
+Connection::~Connection() {
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+
+void Connection::sendResponse(uint32_t code, const char* msg) {
+    protocol::Response response;
+    response.code = code;
+    response.msg = { msg, true };
+
+    send(response);
+}
+
+
+void Connection::sendResponse(uint32_t code, const string& msg) {
+    protocol::Response response;
+    response.code = code;
+    response.msg = { msg, false };
+
+    send(response);
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 客户端连接状态
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <sys/socket.h>
+
+#include "../Protocols.h"
+#include "./FrameDecoder.h"
+#include "./OutputQueue.h"
+
+namespace vl {
+namespace server {
+
+/**
+ * 单个客户端连接的状态。
+ *
+ * 连接上的读写都是非阻塞的：收到的字节交给 decoder 切分成报文，
+ * 待发送的应答先写入 out，socket 可写时再发出去。
+ */
+class Connection {
+public:
+    explicit Connection(int fd);
+    ~Connection();
+
+    Connection(const Connection&) = delete;
+    Connection& operator = (const Connection&) = delete;
+
+    int fd;
+
+    /** 连接编号。由 SocketServer 分配。 */
+    uint32_t id = 0;
+
+    /* 接收 */
+
+    FrameDecoder decoder;
+
+    /** 解码结果。引用 decoder 中的数据。 */
+    protocol::MessagePool messages;
+
+    /* 发送 */
+
+    OutputQueue out;
+
+    /** 应答发送完毕后关闭连接。 */
+    bool closeAfterFlush = false;
+
+    /** 是否正在等待 socket 可写。 */
+    bool pollingOut = false;
+
+    /** 订阅的事件。protocol::Subscribe::EVENT_* 的组合。 */
+    uint32_t subscriptions = 0;
+
+    /** 转发到该连接、尚未结束的子进程输出流数量。 */
+    int outputStreams = 0;
+
+    /* 统计。见 Stats::Latency。时刻由 monotonicNanos() 给出，为 0 表示不需要记录。 */
+
+    /** 接受连接的时刻。第一条报文接收完整后清零。 */
+    uint64_t acceptedAt = 0;
+
+    /** 最近一次启动子进程的时刻。应答发出后清零。 */
+    uint64_t spawnedAt = 0;
+
+    /** 由 trace 使用。时刻由 trace::now() 给出，为 0 表示尚未发生。 */
+    struct {
+        /** 当前报文的第一个字节到达的时刻。 */
+        uint64_t frameStartedAt = 0;
+
+        /** 当前报文的 header 接收完整的时刻。 */
+        uint64_t headerReceivedAt = 0;
+
+        /** 应答写入发送队列的时刻。 */
+        uint64_t respondQueuedAt = 0;
+
+        /** 应答对应的请求编号。 */
+        uint64_t request = 0;
+    } tracing;
+
+    static const int RING_MAX_IOV = 16;
+
+    /** 由 io_uring 后端使用。 */
+    struct {
+        /** 已提交但尚未完成的操作数。 */
+        int pendingOps = 0;
+
+        bool recvPending = false;
+        bool sendPending = false;
+        bool closeQueued = false;
+
+        /** SQ 已满，recv 或 flush 推迟到下一轮收割后。推迟期间计入 pendingOps。 */
+        bool recvDeferred = false;
+        bool flushDeferred = false;
+
+        /** 已交给内核发送的数据。发送期间不能修改。 */
+        OutputQueue sending;
+
+        iovec iov[RING_MAX_IOV];
+        msghdr msg;
+    } ring;
+
+    /**
+     * 编码一条报文，追加到发送队列。
+     */
+    template <typename M>
+    void send(const M& message) {
+        protocol::encode(message, out);
+    }
+
+    /**
+     * 发送通用应答。msg 需为静态字符串（如字符串常量），发送时直接引用，不拷贝。
+     */
+    void sendResponse(uint32_t code, const char* msg);
+
+    /**
+     * 发送通用应答。msg 会被拷贝。
+     */
+    void sendResponse(uint32_t code, const std::string& msg);
+
+    bool hasPendingOutput() const {
+        return !out.empty();
+    }
+
+    /**
+     * 尚未交给内核的数据量。包括 io_uring 正在发送的部分。
+     */
+    size_t backlog() const {
+        return out.pendingBytes() + ring.sending.pendingBytes();
+    }
+
+    /**
+     * 可以绕过发送队列，直接向 fd 写入。
+     */
+    bool canWriteDirectly() const {
+        return out.empty() && ring.sending.empty() && !ring.sendPending && !closeAfterFlush;
+    }
+};
+
+} // namespace server
+} // namespace vl
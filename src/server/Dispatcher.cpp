@@ -0,0 +1,441 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 协议处理
+ * 创建于 2026年10月17日
+ */
+
+#include "./Dispatcher.h"
+#include "../Log.h"
+#include "../Trace.h"
+
+#include <cstring>
+#include <string>
+
+#include <sched.h>
+#include <linux/ioprio.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+/**
+ * 把请求中的启动选项转换为 controls 与需要转发的输出流。
+ *
+ * @return 成功时返回 nullptr，否则返回错误描述（静态字符串）。
+ */
+static const char* parseLaunchOptions(
+    const vector<protocol::LaunchOption>& options,
+    spawn::ResourceControls& controls,
+    uint32_t& capture
+) {
+    using Option = protocol::LaunchOption;
+    using Controls = spawn::ResourceControls;
+
+    controls = Controls();
+    CPU_ZERO(&controls.affinity);
+    capture = 0;
+    bool hasIoClass = false;
+
+    for (auto& it : options) {
+        int64_t value = int64_t(it.value);
+
+        switch (it.key) {
+            case Option::KEY_ADDRESS_SPACE:
+                controls.mask |= Controls::ADDRESS_SPACE;
+                controls.addressSpace = it.value;
+                break;
+
+            case Option::KEY_CPU_TIME:
+                controls.mask |= Controls::CPU_TIME;
+                controls.cpuTime = it.value;
+                break;
+
+            case Option::KEY_OPEN_FILES:
+                controls.mask |= Controls::OPEN_FILES;
+                controls.openFiles = it.value;
+                break;
+
+            case Option::KEY_CPU:
+                if (it.value >= CPU_SETSIZE) {
+                    return "cpu index out of range.";
+                }
+                controls.mask |= Controls::AFFINITY;
+                CPU_SET(it.value, &controls.affinity);
+                break;
+
+            case Option::KEY_NICE:
+                if (value < -20 || value > 19) {
+                    return "nice value should be within [-20, 19].";
+                }
+                controls.mask |= Controls::NICE;
+                controls.nice = int(value);
+                break;
+
+            case Option::KEY_SCHED_POLICY:
+                if (value != SCHED_OTHER && value != SCHED_FIFO && value != SCHED_RR
+                    && value != SCHED_BATCH && value != SCHED_IDLE
+                ) {
+                    return "unknown scheduling policy.";
+                }
+                controls.mask |= Controls::SCHEDULER;
+                controls.schedPolicy = int(value);
+                break;
+
+            case Option::KEY_SCHED_PRIORITY:
+                if (value < 0 || value > 99) {
+                    return "scheduling priority should be within [0, 99].";
+                }
+                controls.mask |= Controls::SCHEDULER;
+                controls.schedPriority = int(value);
+                break;
+
+            case Option::KEY_IO_CLASS:
+                if (value < IOPRIO_CLASS_NONE || value > IOPRIO_CLASS_IDLE) {
+                    return "unknown io priority class.";
+                }
+                controls.mask |= Controls::IO_PRIORITY;
+                controls.ioClass = int(value);
+                hasIoClass = true;
+                break;
+
+            case Option::KEY_IO_LEVEL:
+                if (value < 0 || value > 7) {
+                    return "io priority level should be within [0, 7].";
+                }
+                controls.mask |= Controls::IO_PRIORITY;
+                controls.ioLevel = int(value);
+                break;
+
+            case Option::KEY_CAPTURE_OUTPUT:
+                if (it.value & ~uint64_t(
+                    protocol::OutputChunk::STREAM_STDOUT | protocol::OutputChunk::STREAM_STDERR
+                )) {
+                    return "unknown output stream.";
+                }
+                capture = uint32_t(it.value);
+                break;
+
+            default:
+                return "unknown launch option.";
+        }
+    }
+
+    // 只给出 I/O 优先级时，按 best-effort 类处理。
+    if ((controls.mask & Controls::IO_PRIORITY) && !hasIoClass) {
+        controls.ioClass = IOPRIO_CLASS_BE;
+    }
+
+    return nullptr;
+}
+
+
+/**
+ * 解析启动选项。失败时回复错误。
+ *
+ * @param capture 需要转发的输出流。protocol::OutputChunk::STREAM_* 的组合。
+ *
+ * @return 成功时返回 true。
+ */
+static bool parseLaunchParams(
+    const vector<protocol::LaunchOption>& options,
+    spawn::LaunchParams& params,
+    uint32_t& capture,
+    DispatchContext& ctx
+) {
+    static spawn::ResourceControls controls;
+
+    params = spawn::LaunchParams();
+    capture = 0;
+    if (options.empty()) {
+        return true;
+    }
+
+    const char* err = parseLaunchOptions(options, controls, capture);
+    if (err) {
+        LOG_ERROR("invalid launch options: ", err);
+        ctx.conn.sendResponse(1, err);
+        return false;
+    }
+
+    if (!controls.empty()) {
+        params.controls = &controls;
+    }
+
+    return true;
+}
+
+
+/**
+ * 按 params 启动一个子进程。需要转发输出或写日志时，先创建输出管道，启动后开始转发。
+ *
+ * @return 子进程 pid。失败时返回 -errno。
+ */
+template <typename LaunchFn>
+static pid_t launchWithCapture(
+    spawn::LaunchParams params, uint32_t capture, DispatchContext& ctx, LaunchFn launch
+) {
+    bool piped = capture || ctx.output.capturingLogs();
+
+    if (piped) {
+        int err = ctx.output.prepare(capture, params);
+        if (err) {
+            return err;
+        }
+    }
+
+    pid_t pid = launch(params);
+
+    uint64_t now = monotonicNanos();
+    if (pid > 0) {
+        ctx.stats.add(Stats::SPAWNS);
+        ctx.stats.record(Stats::DECODE_TO_SPAWN, now - ctx.decodedAt);
+        ctx.conn.spawnedAt = now;
+    } else {
+        ctx.stats.add(Stats::SPAWN_FAILURES);
+    }
+
+    if (piped) {
+        ctx.output.commit(pid, &ctx.conn);
+    }
+
+    // 输出流结束前连接保持打开。
+    if (capture && pid > 0) {
+        ctx.conn.closeAfterFlush = false;
+    }
+
+    return pid;
+}
+
+/**
+ * 各请求报文的处理函数。返回值同 processFrame()。
+ * 新增请求报文时，在这里加上对应的 handle()。
+ */
+struct Handlers {
+
+    static int handle(const protocol::ShellLaunch& msg, DispatchContext& ctx) {
+        spawn::LaunchParams params;
+        uint32_t capture;
+        if (!parseLaunchParams(msg.options, params, capture, ctx)) {
+            return 1;
+        }
+
+        pid_t pid = launchWithCapture(params, capture, ctx, [&] (const spawn::LaunchParams& params) {
+            return ctx.launcher.launchShell(msg.cmd, params);
+        });
+        if (pid < 0) {
+            LOG_ERROR_KV(
+                "failed to create subprocess!", "cmd", msg.cmd, "errno", -pid, "error", strerror(-pid)
+            );
+            string errMsg = "failed to create subprocess: ";
+            errMsg.append(strerror(-pid));
+            ctx.conn.sendResponse(1, errMsg);
+            return 1;
+        }
+
+        ctx.conn.sendResponse(0, "");
+
+        return 0;
+    }
+
+
+    static int handle(const protocol::BatchShellLaunch& msg, DispatchContext& ctx) {
+        spawn::LaunchParams params;
+        uint32_t capture;
+        if (!parseLaunchParams(msg.options, params, capture, ctx)) {
+            return 1;
+        }
+
+        static protocol::BatchLaunchResponse response;
+        response.code = 0;
+        response.entries.clear();
+
+        size_t launched = 0;
+        for (auto& cmd : msg.cmds) {
+            pid_t pid = launchWithCapture(params, capture, ctx, [&] (const spawn::LaunchParams& params) {
+                return ctx.launcher.launchShell(cmd, params);
+            });
+            if (pid < 0) {
+                LOG_ERROR_KV(
+                    "failed to create subprocess.", "cmd", cmd, "errno", -pid, "error", strerror(-pid)
+                );
+                // 与单条启动相同，调用者需要知道失败的原因（如 ENOENT 与 EAGAIN）。
+                response.code = 1;
+                response.entries.push_back({ uint32_t(-pid), -1 });
+            } else {
+                launched++;
+                response.entries.push_back({ 0, pid });
+            }
+        }
+
+        ctx.conn.send(response);
+
+        return launched > 0 ? 0 : 1;
+    }
+
+
+    static int handle(const protocol::ExecLaunch& msg, DispatchContext& ctx) {
+        if (msg.path.empty()) {
+            const char* errMsg = "empty executable path!";
+            LOG_ERROR(errMsg);
+            ctx.conn.sendResponse(1, errMsg);
+            return 1;
+        }
+
+        spawn::LaunchParams params;
+        uint32_t capture;
+        if (!parseLaunchParams(msg.options, params, capture, ctx)) {
+            return 1;
+        }
+
+        pid_t pid = launchWithCapture(params, capture, ctx, [&] (const spawn::LaunchParams& params) {
+            return ctx.launcher.launchExec(msg.path, msg.argv, msg.env, msg.cwd, params);
+        });
+        if (pid < 0) {
+            string errMsg = "failed to execute ";
+            errMsg.append(msg.path).append(": ").append(strerror(-pid));
+            LOG_ERROR(errMsg);
+            ctx.conn.sendResponse(1, errMsg);
+            return 1;
+        }
+
+        ctx.conn.sendResponse(0, "");
+
+        return 0;
+    }
+
+
+    static int handle(const protocol::Subscribe& msg, DispatchContext& ctx) {
+        ctx.conn.subscriptions = msg.events;
+
+        // 订阅后连接保持打开，直到 client 关闭。
+        if (msg.events) {
+            ctx.conn.closeAfterFlush = false;
+        }
+
+        ctx.conn.sendResponse(0, "");
+
+        return 1;
+    }
+
+
+    static int handle(const protocol::StatusQuery&, DispatchContext& ctx) {
+        static protocol::StatusResponse response;
+        response.code = 0;
+        response.entries.clear();
+
+        auto& children = ctx.supervisor.snapshot();
+        uint64_t now = monotonicMicros();
+
+        for (auto* child : children) {
+            auto& sample = child->sample;
+            auto& entry = response.entries.emplace_back();
+            entry.pid = child->pid;
+            entry.state = uint32_t(uint8_t(sample.state));
+            entry.startTime = child->startTime;
+            entry.userTime = sample.userTime;
+            entry.systemTime = sample.systemTime;
+            entry.rss = sample.rss;
+            entry.readBytes = sample.readBytes;
+            entry.writeBytes = sample.writeBytes;
+            entry.sampleAge = sample.sampledAt ? now - sample.sampledAt : 0;
+            entry.cmd = child->cmd;
+        }
+
+        ctx.conn.send(response);
+
+        return 1;
+    }
+
+
+    static int handle(const protocol::StatsQuery&, DispatchContext& ctx) {
+        static protocol::StatsResponse response;
+        response.code = 0;
+        response.uptime = (monotonicNanos() - ctx.stats.startedAt) / 1000;
+
+        response.counters.clear();
+        for (int i = 0; i < Stats::COUNTER_COUNT; i++) {
+            auto counter = Stats::Counter(i);
+            response.counters.push_back({ Stats::counterName(counter), ctx.stats.counter(counter) });
+        }
+
+        response.histograms.resize(Stats::LATENCY_COUNT);
+        for (int i = 0; i < Stats::LATENCY_COUNT; i++) {
+            auto latency = Stats::Latency(i);
+            auto& histogram = ctx.stats.histogram(latency);
+            auto& entry = response.histograms[i];
+
+            entry.name = Stats::latencyName(latency);
+            entry.count = histogram.count();
+            entry.sum = histogram.sum();
+            entry.min = entry.count ? histogram.min() : 0;
+            entry.max = histogram.max();
+            entry.p50 = histogram.percentile(500);
+            entry.p90 = histogram.percentile(900);
+            entry.p99 = histogram.percentile(990);
+            entry.p999 = histogram.percentile(999);
+
+            // 只发送非空的桶。
+            entry.buckets.clear();
+            for (int b = 0; b < Histogram::BUCKET_COUNT; b++) {
+                if (uint64_t n = histogram.bucketCount(b)) {
+                    entry.buckets.push_back({ Histogram::lowerBound(b), Histogram::upperBound(b), n });
+                }
+            }
+        }
+
+        ctx.conn.send(response);
+
+        return 1;
+    }
+
+};
+
+
+/** processFrame() 开始解码的时刻。仅在启用 trace 时设置。 */
+static uint64_t decodeBegin = 0;
+
+
+/**
+ * 在 Handlers 外记录 trace：解码在调用 handle() 前完成。
+ */
+struct TracedHandlers {
+
+    template <typename M>
+    static int handle(const M& msg, DispatchContext& ctx) {
+        if (!trace::enabled()) {
+            return Handlers::handle(msg, ctx);
+        }
+
+        trace::complete("protocol", "decode", decodeBegin, trace::now());
+        trace::Span span("protocol", M::name);
+        return Handlers::handle(msg, ctx);
+    }
+
+};
+
+
+using RequestTable = protocol::DispatchTable<protocol::Requests, TracedHandlers, DispatchContext>;
+
+
+int processFrame(const FrameDecoder::Frame& frame, DispatchContext& ctx) {
+    const char* body = frame.data + protocol::HEADER_LEN;
+
+    if (trace::enabled()) {
+        decodeBegin = trace::now();
+    }
+
+    int res = RequestTable::dispatch(frame.type, body, frame.length, ctx.conn.messages, ctx);
+
+    if (res == protocol::DISPATCH_UNKNOWN_TYPE) {
+        LOG_WARN("type code ", frame.type, " matches no protocols.");
+    } else if (res == protocol::DISPATCH_DECODE_FAILED) {
+        LOG_WARN("failed to decode body of type ", frame.type, ", length: ", frame.length);
+    }
+
+    return res;
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 协议处理
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "../Protocols.h"
+#include "./Connection.h"
+#include "./FrameDecoder.h"
+#include "./ChildSupervisor.h"
+#include "./OutputForwarder.h"
+#include "./Stats.h"
+#include "../spawn/Launcher.h"
+
+namespace vl {
+namespace server {
+
+/**
+ * 报文处理函数可以访问的状态。
+ */
+struct DispatchContext {
+    /** 报文来自的连接。 */
+    Connection& conn;
+
+    spawn::Launcher& launcher;
+
+    ChildSupervisor& supervisor;
+
+    OutputForwarder& output;
+
+    Stats& stats;
+
+    /** 报文接收完整的时刻。见 monotonicNanos()。 */
+    uint64_t decodedAt;
+};
+
+
+/**
+ * 解码一条报文并处理。应答写入 ctx.conn 的发送缓冲。
+ * 解码结果存放在 ctx.conn.messages 中。
+ *
+ * @return 报文无法解码或类型未知时，返回 protocol::DISPATCH_DECODE_FAILED
+ *         或 protocol::DISPATCH_UNKNOWN_TYPE；
+ *         异常退出时，返回负数；
+ *         正常退出时，如果希望结束监听，不再服务下一个 client，返回0；否则返回正数。
+ */
+int processFrame(const FrameDecoder::Frame& frame, DispatchContext& ctx);
+
+} // namespace server
+} // namespace vl
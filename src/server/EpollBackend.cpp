@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 epoll 与非阻塞 read/write 的 I/O 后端
+ * 创建于 2026年10月17日
+ */
+
+#include "./EpollBackend.h"
+#include "./SocketServer.h"
+#include "../Log.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+int EpollBackend::start(int listenFd) {
+    this->listenFd = listenFd;
+    return loop.add(listenFd, EPOLLIN, [this] (uint32_t) { onAcceptable(); });
+}
+
+
+void EpollBackend::pauseAccept() {
+    if (listenFd >= 0) {
+        loop.remove(listenFd);
+        listenFd = -1;
+    }
+}
+
+
+int EpollBackend::resumeAccept(int listenFd) {
+    pauseAccept();
+    return start(listenFd);
+}
+
+
+void EpollBackend::flush(Connection* conn) {
+    doFlush(conn);
+}
+
+
+void EpollBackend::onAcceptable() {
+    while (true) {
+        sockaddr_un client;
+        socklen_t clientLen = sizeof(client);
+
+        int connFd = accept4(
+            listenFd, (sockaddr*) &client, &clientLen, SOCK_NONBLOCK | SOCK_CLOEXEC
+        );
+
+        if (connFd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARN("socket connection failed.");
+            }
+
+            return;
+        }
+
+        auto* conn = server.addConnection(connFd);
+
+        if (loop.add(connFd, EPOLLIN, [this, conn] (uint32_t events) {
+            onConnectionEvent(conn, events);
+        })) {
+            server.removeConnection(conn);
+        }
+    }
+}
+
+
+void EpollBackend::onConnectionEvent(Connection* conn, uint32_t events) {
+    if (events & EPOLLOUT) {
+        if (doFlush(conn) < 0) {
+            return;
+        }
+    }
+
+    if (conn->closeAfterFlush || !(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+        return;
+    }
+
+    readFromConnection(conn);
+
+    doFlush(conn);
+}
+
+
+int EpollBackend::readFromConnection(Connection* conn) {
+    while (!conn->closeAfterFlush && !server.shouldPauseReceive(conn)) {
+        size_t len;
+        char* buf = server.prepareReceive(conn, len);
+
+        ssize_t bytes = read(conn->fd, buf, len);
+        if (bytes > 0) {
+            server.onReceived(conn, bytes);
+            continue;
+        } else if (bytes == 0) {
+            server.onReceiveFailed(conn, 0);
+            return -1;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+
+        server.onReceiveFailed(conn, errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+int EpollBackend::doFlush(Connection* conn) {
+    const int MAX_IOV = 64;
+    iovec iov[MAX_IOV];
+
+    while (conn->hasPendingOutput()) {
+        int iovCount = conn->out.fillIov(iov, MAX_IOV);
+        ssize_t bytes = writev(conn->fd, iov, iovCount);
+
+        if (bytes > 0) {
+            conn->out.consume(bytes);
+            server.onSent(conn);
+            continue;
+        } else if (bytes < 0 && errno == EINTR) {
+            continue;
+        } else if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            bool pauseReceive = conn->closeAfterFlush || server.shouldPauseReceive(conn);
+            loop.modify(conn->fd, pauseReceive ? EPOLLOUT : EPOLLIN | EPOLLOUT);
+            conn->pollingOut = true;
+            return 0;
+        }
+
+        // 对端已经断开。
+        closeConnection(conn);
+        return -1;
+    }
+
+    if (conn->closeAfterFlush) {
+        closeConnection(conn);
+        return -1;
+    }
+
+    if (conn->pollingOut) {
+        loop.modify(conn->fd, EPOLLIN);
+        conn->pollingOut = false;
+        server.onOutputDrained(conn);
+    }
+
+    return 0;
+}
+
+
+void EpollBackend::closeConnection(Connection* conn) {
+    loop.remove(conn->fd);
+    server.removeConnection(conn);
+}
+
+} // namespace server
+} // namespace vl
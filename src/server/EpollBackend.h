@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 epoll 与非阻塞 read/write 的 I/O 后端
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "./IoBackend.h"
+
+namespace vl {
+namespace server {
+
+class EpollBackend : public IoBackend {
+public:
+    using IoBackend::IoBackend;
+
+    virtual int start(int listenFd) override;
+    virtual void pauseAccept() override;
+    virtual int resumeAccept(int listenFd) override;
+    virtual void flush(Connection* conn) override;
+    virtual const char* name() const override { return "epoll"; }
+
+protected:
+    void onAcceptable();
+    void onConnectionEvent(Connection* conn, uint32_t events);
+
+    /**
+     * 读取并处理数据，直到 socket 暂无数据可读。
+     *
+     * @return 对端关闭或读取出错时返回负数，否则返回 0。
+     */
+    int readFromConnection(Connection* conn);
+
+    /**
+     * @return 连接已被关闭时返回负数，否则返回 0。
+     */
+    int doFlush(Connection* conn);
+    void closeConnection(Connection* conn);
+
+    int listenFd = -1;
+};
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 epoll 的事件循环
+ * 创建于 2026年10月17日
+ */
+
+#include "./EventLoop.h"
+#include "../Log.h"
+
+#include <cerrno>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+EventLoop::~EventLoop() {
+    for (auto* it : handlers) {
+        delete it;
+    }
+
+    for (auto* it : graveyard) {
+        delete it;
+    }
+
+    if (wakeupFd != -1) {
+        close(wakeupFd);
+    }
+
+    if (epollFd != -1) {
+        close(epollFd);
+    }
+}
+
+
+int EventLoop::init() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        LOG_ERROR("failed to create epoll instance.");
+        return -1;
+    }
+
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd < 0) {
+        LOG_ERROR("failed to create eventfd.");
+        return -2;
+    }
+
+    return add(wakeupFd, EPOLLIN, [this] (uint32_t) {
+        uint64_t value;
+        while (read(wakeupFd, &value, sizeof(value)) > 0)
+            ;
+    });
+}
+
+
+EventLoop::Handler* EventLoop::findHandler(int fd) {
+    if (fd < 0 || size_t(fd) >= handlers.size()) {
+        return nullptr;
+    }
+
+    return handlers[fd];
+}
+
+
+int EventLoop::add(int fd, uint32_t events, Callback callback) {
+    if (findHandler(fd)) {
+        LOG_ERROR("fd ", fd, " already registered.");
+        return -1;
+    }
+
+    auto* handler = new Handler { fd, false, std::move(callback) };
+
+    epoll_event ev {};
+    ev.events = events;
+    ev.data.ptr = handler;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR_KV("epoll_ctl add failed.", "fd", fd, "errno", errno);
+        delete handler;
+        return -2;
+    }
+
+    if (size_t(fd) >= handlers.size()) {
+        handlers.resize(fd + 1, nullptr);
+    }
+
+    handlers[fd] = handler;
+    return 0;
+}
+
+
+int EventLoop::modify(int fd, uint32_t events) {
+    auto* handler = findHandler(fd);
+    if (!handler) {
+        return -1;
+    }
+
+    epoll_event ev {};
+    ev.events = events;
+    ev.data.ptr = handler;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        LOG_ERROR_KV("epoll_ctl mod failed.", "fd", fd, "errno", errno);
+        return -2;
+    }
+
+    return 0;
+}
+
+
+int EventLoop::remove(int fd) {
+    auto* handler = findHandler(fd);
+    if (!handler) {
+        return -1;
+    }
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+
+    handler->removed = true;
+    handlers[fd] = nullptr;
+
+    // 同一批事件里可能还有指向它的 epoll_event，不能立即释放。
+    graveyard.push_back(handler);
+    return 0;
+}
+
+
+int EventLoop::run() {
+    const int MAX_EVENTS = 64;
+    epoll_event events[MAX_EVENTS];
+
+    isRunning = true;
+    while (!stopRequested) {
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            LOG_ERROR_KV("epoll_wait failed.", "errno", errno);
+            isRunning = false;
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            auto* handler = (Handler*) events[i].data.ptr;
+            if (handler->removed) {
+                continue;
+            }
+
+            handler->callback(events[i].events);
+        }
+
+        for (auto* it : graveyard) {
+            delete it;
+        }
+        graveyard.clear();
+    }
+
+    isRunning = false;
+    return 0;
+}
+
+
+void EventLoop::stop() {
+    stopRequested = true;
+
+    if (wakeupFd != -1) {
+        uint64_t one = 1;
+        write(wakeupFd, &one, sizeof(one));
+    }
+}
+
+} // namespace server
+} // namespace vl
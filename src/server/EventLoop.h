@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 epoll 的事件循环
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <sys/epoll.h>
+
+namespace vl {
+namespace server {
+
+/**
+ * 单线程 epoll 事件循环。
+ *
+ * 所有需要等待的 fd（监听 socket、客户端连接等）都注册到这里，
+ * 由 run() 统一分发。回调中可以安全地添加或移除其他 fd。
+ */
+class EventLoop {
+public:
+    using Callback = std::function<void (uint32_t events)>;
+
+    EventLoop() = default;
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator = (const EventLoop&) = delete;
+
+    /**
+     * @return 成功时返回 0。
+     */
+    int init();
+
+    int add(int fd, uint32_t events, Callback callback);
+    int modify(int fd, uint32_t events);
+
+    /**
+     * 移除 fd 的监听。不会关闭 fd。
+     */
+    int remove(int fd);
+
+    /**
+     * 运行事件循环，直到 stop() 被调用。run() 之前调用过 stop() 时立即返回。
+     *
+     * @return 异常退出时返回负数，否则返回 0。
+     */
+    int run();
+
+    /**
+     * 请求事件循环退出。可以在信号处理函数中调用，也可以在 run() 之前调用。
+     * 请求不会被撤销。
+     */
+    void stop();
+
+    bool running() const { return isRunning; }
+
+protected:
+    struct Handler {
+        int fd;
+        bool removed;
+        Callback callback;
+    };
+
+    Handler* findHandler(int fd);
+
+    int epollFd = -1;
+    int wakeupFd = -1;
+    volatile bool isRunning = false;
+
+    /** 已调用 stop()。run() 不会清除它，否则启动期间收到的 SIGTERM 会丢失。 */
+    volatile bool stopRequested = false;
+
+    std::vector<Handler*> handlers;
+
+    /** 本轮分发中被移除的 handler。本轮结束后统一释放。 */
+    std::vector<Handler*> graveyard;
+};
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 增量报文解码器
+ * 创建于 2026年10月17日
+ */
+
+#include "./FrameDecoder.h"
+#include "../Protocols.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+char* FrameDecoder::prepare(size_t& len) {
+    if (start == end) {
+        start = end = 0;
+    }
+
+    size_t target = RECEIVE_CHUNK;
+    if (state == State::BODY) {
+        target = max(target, size_t(protocol::HEADER_LEN + bodyLength));
+    }
+
+    // 剩余空间不足以放下当前报文时，把未处理的数据移到开头。
+    if (start > 0 && buf.size() - start < target) {
+        memmove(buf.data(), buf.data() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+
+    if (buf.size() < target) {
+        buf.resize(target);
+    }
+
+    len = buf.size() - end;
+    return buf.data() + end;
+}
+
+
+void FrameDecoder::commit(size_t bytes) {
+    end += bytes;
+}
+
+
+size_t FrameDecoder::feed(const char* data, size_t len) {
+    size_t space;
+    char* dest = prepare(space);
+
+    size_t bytes = min(space, len);
+    memcpy(dest, data, bytes);
+    commit(bytes);
+    return bytes;
+}
+
+
+FrameDecoder::Result FrameDecoder::next(Frame& frame) {
+    const size_t headerLen = protocol::HEADER_LEN;
+
+    while (true) {
+        size_t available = end - start;
+
+        switch (state) {
+            case State::HEADER: {
+                if (available < headerLen) {
+                    return NEED_MORE;
+                }
+
+                const char* header = buf.data() + start;
+                if (memcmp(header, protocol::MAGIC_STR, 4)) {
+                    state = State::BROKEN;
+                    return ERR_MAGIC;
+                }
+
+                uint32_t type;
+                uint64_t length;
+                memcpy(&type, header + 4, sizeof(type));
+                memcpy(&length, header + 8, sizeof(length));
+                type = be32toh(type);
+                length = be64toh(length);
+
+                if (length > maxFrameSize) {
+                    start += headerLen;
+                    discardRemaining = length;
+                    state = State::DISCARD;
+
+                    frame.type = type;
+                    frame.data = nullptr;
+                    frame.length = length;
+                    return ERR_TOO_LARGE;
+                }
+
+                bodyLength = length;
+                state = State::BODY;
+                break;
+            }
+
+            case State::BODY: {
+                if (available < headerLen + bodyLength) {
+                    return NEED_MORE;
+                }
+
+                const char* header = buf.data() + start;
+                uint32_t type;
+                memcpy(&type, header + 4, sizeof(type));
+
+                frame.type = be32toh(type);
+                frame.data = header;
+                frame.length = bodyLength;
+
+                start += headerLen + bodyLength;
+                state = State::HEADER;
+                return FRAME_READY;
+            }
+
+            case State::DISCARD: {
+                size_t bytes = size_t(min(uint64_t(available), discardRemaining));
+                start += bytes;
+                discardRemaining -= bytes;
+
+                if (discardRemaining > 0) {
+                    return NEED_MORE;
+                }
+
+                state = State::HEADER;
+                break;
+            }
+
+            case State::BROKEN: {
+                return ERR_MAGIC;
+            }
+        }
+    }
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 增量报文解码器
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vl {
+namespace server {
+
+/**
+ * 从字节流中切分报文的状态机。
+ *
+ * 数据可以按任意大小分段到达。缓冲区在连接的整个生命周期内复用，
+ * 大小不会超过 max(HEADER_LEN + maxFrameSize, RECEIVE_CHUNK)。
+ * 超过 maxFrameSize 的报文不会被缓存：其 body 会被直接丢弃，之后继续解码下一条报文。
+ *
+ * 典型用法：
+ *
+ *   size_t len;
+ *   char* buf = decoder.prepare(len);
+ *   ssize_t n = read(fd, buf, len);
+ *   decoder.commit(n);
+ *
+ *   FrameDecoder::Frame frame;
+ *   while (decoder.next(frame) == FrameDecoder::FRAME_READY) { ... }
+ */
+class FrameDecoder {
+public:
+    /** 每次接收至少预留的空间。连接上可能连续到达多条报文。 */
+    static const size_t RECEIVE_CHUNK = 4096;
+
+    static const size_t DEFAULT_MAX_FRAME_SIZE = 1024 * 1024;
+
+    enum Result {
+        FRAME_READY = 1,
+        NEED_MORE = 0,
+
+        /** magic 不正确。之后的数据无法再切分，连接应当关闭。 */
+        ERR_MAGIC = -1,
+
+        /** 报文过长。frame 中的 type 与 length 有效，data 为 nullptr。 */
+        ERR_TOO_LARGE = -2,
+    };
+
+    struct Frame {
+        uint32_t type;
+
+        /** 指向报文开头（含 header）。下一次调用 prepare() 或 feed() 前有效。 */
+        const char* data;
+
+        /** body 长度，不含 header。 */
+        uint64_t length;
+    };
+
+    void setMaxFrameSize(size_t size) { maxFrameSize = size; }
+
+    /**
+     * 获取可直接写入的空间。
+     *
+     * @param len 输出可写入的字节数。始终大于 0。
+     */
+    char* prepare(size_t& len);
+
+    /**
+     * 确认已向 prepare() 返回的位置写入 bytes 字节。
+     */
+    void commit(size_t bytes);
+
+    /**
+     * 拷贝一段数据进入解码器。
+     *
+     * @return 实际接收的字节数。可能小于 len，此时应先用 next() 取走报文。
+     */
+    size_t feed(const char* data, size_t len);
+
+    /**
+     * 取出下一条完整报文。
+     */
+    Result next(Frame& frame);
+
+    /**
+     * 当前缓存的、尚未组成完整报文的字节数。
+     */
+    size_t bufferedBytes() const { return end - start; }
+
+    /**
+     * 是否处于一条报文的中间（已收到部分 header 或 body）。
+     */
+    bool midFrame() const { return end > start || state == State::DISCARD; }
+
+    /**
+     * 当前报文的 header 是否已经完整收到。
+     */
+    bool headerReceived() const { return state == State::BODY || state == State::DISCARD; }
+
+protected:
+    enum class State {
+        HEADER,
+        BODY,
+        DISCARD,
+        BROKEN,
+    };
+
+    State state = State::HEADER;
+
+    size_t maxFrameSize = DEFAULT_MAX_FRAME_SIZE;
+
+    /** 当前报文的 body 长度。state 为 BODY 时有效。 */
+    uint64_t bodyLength = 0;
+
+    /** 仍需丢弃的字节数。state 为 DISCARD 时有效。 */
+    uint64_t discardRemaining = 0;
+
+    std::vector<char> buf;
+    size_t start = 0;
+    size_t end = 0;
+};
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 收到的报文的录制文件
+ * 创建于 2026年10月17日
+ */
+
+#include "./FrameRecorder.h"
+#include "../ProtocolCodec.h"
+#include "../Log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+FrameRecorder::~FrameRecorder() {
+    close();
+}
+
+
+int FrameRecorder::open(const string& path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOG_ERROR("failed to open frame record file ", path, ": ", strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        LOG_ERROR("failed to stat frame record file ", path, ": ", strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    this->fd = fd;
+    this->path = path;
+    pid = uint32_t(getpid());
+
+    if (st.st_size == 0) {
+        buf.insert(buf.end(), FILE_MAGIC, FILE_MAGIC + FILE_MAGIC_LEN);
+    }
+
+    return 0;
+}
+
+
+void FrameRecorder::record(uint32_t connection, const char* frame, size_t len) {
+    if (fd < 0) {
+        return;
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    size_t offset = buf.size();
+    buf.resize(offset + RECORD_HEADER_LEN + len);
+
+    char* p = buf.data() + offset;
+    p = protocol::writeBE64(p, uint64_t(now.tv_sec) * 1000000000 + now.tv_nsec);
+    p = protocol::writeBE32(p, pid);
+    p = protocol::writeBE32(p, connection);
+    memcpy(p, frame, len);
+
+    if (buf.size() >= FLUSH_THRESHOLD) {
+        flush();
+    }
+}
+
+
+void FrameRecorder::flush() {
+    size_t written = 0;
+
+    while (fd >= 0 && written < buf.size()) {
+        ssize_t n = write(fd, buf.data() + written, buf.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            LOG_ERROR("failed to write frame record file ", path, ": ", n < 0 ? strerror(errno) : "no space");
+            LOG_WARN("frame recording stopped.");
+            ::close(fd);
+            fd = -1;
+            break;
+        }
+
+        written += n;
+    }
+
+    buf.clear();
+}
+
+
+void FrameRecorder::close() {
+    if (fd < 0) {
+        return;
+    }
+
+    flush();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 收到的报文的录制文件
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vl {
+namespace server {
+
+/**
+ * 把收到的每条完整报文原样追加到文件，供 vesper-launcher-replay 重放。
+ *
+ * 文件格式（数字均为 Big Endian）：
+ *
+ *   文件头     8 Bytes   FILE_MAGIC。只在文件为空时写入，之后的运行继续追加
+ *   记录       time (uint64)        到达时刻。CLOCK_REALTIME，单位为纳秒
+ *              pid (uint32)         launcher 的 pid
+ *              connection (uint32)  连接编号。同一 launcher 中唯一
+ *              frame                完整报文（header + body），长度由 header 给出
+ *
+ * magic 不正确或过长而被拒绝的报文不会被记录。
+ *
+ * 写入先进入内存缓冲，每批报文处理完后 flush() 一次。
+ */
+class FrameRecorder {
+public:
+    static constexpr const char* FILE_MAGIC = "VLCAPv1\n";
+    static const size_t FILE_MAGIC_LEN = 8;
+    static const size_t RECORD_HEADER_LEN = 16;
+
+    /** 缓冲超过该值时立即写出。 */
+    static const size_t FLUSH_THRESHOLD = 256 * 1024;
+
+    FrameRecorder() {}
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator = (const FrameRecorder&) = delete;
+
+    /**
+     * 以追加方式打开 path。
+     *
+     * @return 成功时返回 0。
+     */
+    int open(const std::string& path);
+
+    bool enabled() const { return fd >= 0; }
+
+    /**
+     * 记录一条报文。
+     *
+     * @param frame 完整报文，含 header。
+     */
+    void record(uint32_t connection, const char* frame, size_t len);
+
+    /**
+     * 写出缓冲中的记录。出错后停止录制。
+     */
+    void flush();
+
+    void close();
+
+protected:
+    int fd = -1;
+    std::string path;
+    uint32_t pid = 0;
+    std::vector<char> buf;
+};
+
+} // namespace server
+} // namespace vl
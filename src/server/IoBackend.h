@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * socket I/O 后端接口
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "./Connection.h"
+#include "./EventLoop.h"
+
+namespace vl {
+namespace server {
+
+class SocketServer;
+
+/**
+ * 负责监听 socket 与客户端连接上的 accept/read/write。
+ *
+ * 后端把收到的字节写入 SocketServer::prepareReceive() 给出的位置，交给 SocketServer 解析和处理；
+ * SocketServer 把应答写入 Connection::out 后，调用 flush() 让后端发出。
+ */
+class IoBackend {
+public:
+    IoBackend(SocketServer& server, EventLoop& loop) : server(server), loop(loop) {}
+    virtual ~IoBackend() {}
+
+    /**
+     * @return 成功时返回 0。
+     */
+    virtual int start(int listenFd) = 0;
+
+    /**
+     * 停止接受新连接。已有连接不受影响。不会关闭监听 socket。
+     */
+    virtual void pauseAccept() = 0;
+
+    /**
+     * 在新的监听 socket 上恢复接受连接。
+     *
+     * @return 成功时返回 0。
+     */
+    virtual int resumeAccept(int listenFd) = 0;
+
+    /**
+     * 发出 conn 发送缓冲中的数据。
+     * 如果 conn->closeAfterFlush 已设置，发送完毕后关闭连接。
+     */
+    virtual void flush(Connection* conn) = 0;
+
+    virtual const char* name() const = 0;
+
+protected:
+    SocketServer& server;
+    EventLoop& loop;
+};
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * io_uring 最小封装
+ * 创建于 2026年10月17日
+ */
+
+#include "./IoUring.h"
+#include "../Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+static int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return int(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return int(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+
+IoUring::~IoUring() {
+    if (sqes) {
+        munmap(sqes, sqesSize);
+    }
+
+    if (cqRingPtr && cqRingPtr != sqRingPtr) {
+        munmap(cqRingPtr, cqRingSize);
+    }
+
+    if (sqRingPtr) {
+        munmap(sqRingPtr, sqRingSize);
+    }
+
+    if (ringFd != -1) {
+        close(ringFd);
+    }
+}
+
+
+int IoUring::init(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ringFd = ioUringSetup(entries, &params);
+    if (ringFd < 0) {
+        LOG_WARN_KV("io_uring_setup failed.", "errno", errno);
+        ringFd = -1;
+        return -1;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize = cqRingSize = max(sqRingSize, cqRingSize);
+    }
+
+    sqRingPtr = mmap(
+        nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ringFd, IORING_OFF_SQ_RING
+    );
+    if (sqRingPtr == MAP_FAILED) {
+        sqRingPtr = nullptr;
+        LOG_ERROR("failed to map io_uring sq ring.");
+        return -2;
+    }
+
+    if (singleMmap) {
+        cqRingPtr = sqRingPtr;
+    } else {
+        cqRingPtr = mmap(
+            nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringFd, IORING_OFF_CQ_RING
+        );
+        if (cqRingPtr == MAP_FAILED) {
+            cqRingPtr = nullptr;
+            LOG_ERROR("failed to map io_uring cq ring.");
+            return -3;
+        }
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqesPtr = mmap(
+        nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ringFd, IORING_OFF_SQES
+    );
+    if (sqesPtr == MAP_FAILED) {
+        LOG_ERROR("failed to map io_uring sqes.");
+        return -4;
+    }
+    sqes = (io_uring_sqe*) sqesPtr;
+
+    char* sqBase = (char*) sqRingPtr;
+    sq.head = (unsigned*) (sqBase + params.sq_off.head);
+    sq.tail = (unsigned*) (sqBase + params.sq_off.tail);
+    sq.ringMask = (unsigned*) (sqBase + params.sq_off.ring_mask);
+    sq.array = (unsigned*) (sqBase + params.sq_off.array);
+    sq.flags = (unsigned*) (sqBase + params.sq_off.flags);
+    sq.entries = params.sq_entries;
+    sq.localTail = *sq.tail;
+
+    // SQE 下标与 array 下标一一对应，之后不再修改 array。
+    for (unsigned i = 0; i < sq.entries; i++) {
+        sq.array[i] = i;
+    }
+
+    char* cqBase = (char*) cqRingPtr;
+    cq.head = (unsigned*) (cqBase + params.cq_off.head);
+    cq.tail = (unsigned*) (cqBase + params.cq_off.tail);
+    cq.ringMask = (unsigned*) (cqBase + params.cq_off.ring_mask);
+    cq.cqes = (io_uring_cqe*) (cqBase + params.cq_off.cqes);
+
+    return 0;
+}
+
+
+io_uring_sqe* IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sq.head, __ATOMIC_ACQUIRE);
+    if (sq.localTail - head >= sq.entries) {
+        return nullptr;
+    }
+
+    auto* sqe = &sqes[sq.localTail & *sq.ringMask];
+    sq.localTail++;
+
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+
+unsigned IoUring::sqSpace() const {
+    unsigned head = __atomic_load_n(sq.head, __ATOMIC_ACQUIRE);
+    return sq.entries - (sq.localTail - head);
+}
+
+
+int IoUring::submit() {
+    // 以 head 而不是 tail 计数：io_uring_enter 失败时，已发布的 SQE 不会被内核取走。
+    unsigned head = __atomic_load_n(sq.head, __ATOMIC_ACQUIRE);
+    unsigned toSubmit = sq.localTail - head;
+    if (toSubmit == 0) {
+        return 0;
+    }
+
+    __atomic_store_n(sq.tail, sq.localTail, __ATOMIC_RELEASE);
+
+    int res;
+    do {
+        res = ioUringEnter(ringFd, toSubmit, 0, 0);
+    } while (res < 0 && errno == EINTR);
+
+    if (res < 0) {
+        LOG_ERROR_KV("io_uring_enter failed.", "errno", errno);
+    }
+
+    return res;
+}
+
+
+io_uring_cqe* IoUring::peekCqe() {
+    unsigned head = *cq.head;
+    unsigned tail = __atomic_load_n(cq.tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return nullptr;
+    }
+
+    return &cq.cqes[head & *cq.ringMask];
+}
+
+
+void IoUring::cqeSeen() {
+    __atomic_store_n(cq.head, *cq.head + 1, __ATOMIC_RELEASE);
+}
+
+
+bool IoUring::flushOverflow() {
+    if (!(__atomic_load_n(sq.flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)) {
+        return false;
+    }
+
+    int res;
+    do {
+        res = ioUringEnter(ringFd, 0, 0, IORING_ENTER_GETEVENTS);
+    } while (res < 0 && errno == EINTR);
+
+    if (res < 0) {
+        LOG_ERROR_KV("io_uring_enter failed.", "errno", errno);
+        return false;
+    }
+
+    return peekCqe() != nullptr;
+}
+
+} // namespace server
+} // namespace vl
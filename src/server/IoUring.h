@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * io_uring 最小封装
+ * 创建于 2026年10月17日
+ *
+ * 直接使用 io_uring_setup / io_uring_enter 系统调用，不依赖 liburing。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+
+namespace vl {
+namespace server {
+
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator = (const IoUring&) = delete;
+
+    /**
+     * @return 成功时返回 0。内核不支持 io_uring 时返回负数。
+     */
+    int init(unsigned entries);
+
+    int fd() const { return ringFd; }
+
+    /**
+     * 取一个空闲的 SQE。SQ 已满时返回 nullptr，调用者应先 submit()。
+     * 返回的 SQE 已被清零。
+     */
+    io_uring_sqe* getSqe();
+
+    /**
+     * SQ 中还能取出的 SQE 数。
+     */
+    unsigned sqSpace() const;
+
+    /**
+     * 把所有已准备好的 SQE 一次性提交给内核。
+     * 上次提交失败（如 EBUSY）时留在 SQ 中的 SQE 会一并重新提交。
+     *
+     * @return 提交的数量。失败时返回负数。
+     */
+    int submit();
+
+    /**
+     * 取下一个 CQE。CQ 为空时返回 nullptr。
+     * 处理完毕后需要调用 cqeSeen()。
+     */
+    io_uring_cqe* peekCqe();
+    void cqeSeen();
+
+    /**
+     * CQ 曾经满过时，内核把放不下的 CQE 暂存起来，需要 io_uring_enter 才会移回 CQ。
+     * 应在 CQ 取空后调用。
+     *
+     * @return 有 CQE 被移回时返回 true，调用者需要再次读取 CQ。
+     */
+    bool flushOverflow();
+
+protected:
+    int ringFd = -1;
+
+    void* sqRingPtr = nullptr;
+    size_t sqRingSize = 0;
+    void* cqRingPtr = nullptr;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    struct {
+        unsigned* head;
+        unsigned* tail;
+        unsigned* ringMask;
+        unsigned* array;
+        unsigned* flags;
+        unsigned entries;
+
+        /** 已填写但尚未对内核可见的 SQE 尾部。 */
+        unsigned localTail;
+    } sq {};
+
+    struct {
+        unsigned* head;
+        unsigned* tail;
+        unsigned* ringMask;
+        io_uring_cqe* cqes;
+    } cq {};
+};
+
+} // namespace server
+} // namespace vl
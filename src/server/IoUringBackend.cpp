@@ -0,0 +1,440 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 io_uring 的 I/O 后端
+ * 创建于 2026年10月17日
+ */
+
+#include "./IoUringBackend.h"
+#include "./SocketServer.h"
+#include "../Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <sys/socket.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+int IoUringBackend::start(int listenFd) {
+    this->listenFd = listenFd;
+
+    if (ring.init(256)) {
+        return -1;
+    }
+
+    if (loop.add(ring.fd(), EPOLLIN, [this] (uint32_t) { onCompletions(); })) {
+        return -2;
+    }
+
+    queueAccept();
+    if (ring.submit() < 0) {
+        loop.remove(ring.fd());
+        return -3;
+    }
+
+    return 0;
+}
+
+
+void IoUringBackend::pauseAccept() {
+    if (acceptPaused) {
+        return;
+    }
+
+    acceptPaused = true;
+    acceptDeferred = false;
+    listenFd = -1;
+
+    if (acceptArmed) {
+        auto* sqe = getSqe();
+        if (sqe == nullptr) {
+            acceptCancelDeferred = true;
+            return;
+        }
+
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = OP_ACCEPT;
+        sqe->user_data = OP_CANCEL;
+        submitIfIdle();
+    }
+}
+
+
+int IoUringBackend::resumeAccept(int listenFd) {
+    this->listenFd = listenFd;
+    acceptPaused = false;
+    acceptCancelDeferred = false;
+
+    // 旧的 accept 尚未结束时，等它结束后在 onAccept() 中重新提交。
+    if (!acceptArmed) {
+        queueAccept();
+        submitIfIdle();
+    }
+
+    return 0;
+}
+
+
+io_uring_sqe* IoUringBackend::getSqe() {
+    auto* sqe = ring.getSqe();
+    if (sqe == nullptr) {
+        ring.submit();
+        sqe = ring.getSqe();
+    }
+
+    return sqe;
+}
+
+
+bool IoUringBackend::reserveSqes(unsigned n) {
+    if (ring.sqSpace() < n) {
+        ring.submit();
+    }
+
+    return ring.sqSpace() >= n;
+}
+
+
+void IoUringBackend::submitIfIdle() {
+    if (!reaping) {
+        ring.submit();
+    }
+}
+
+
+void IoUringBackend::defer(Connection* conn, bool recv) {
+    auto& state = conn->ring;
+    if (!state.recvDeferred && !state.flushDeferred) {
+        // 推迟期间连接不能被释放。
+        state.pendingOps++;
+        deferred.push_back(conn);
+    }
+
+    (recv ? state.recvDeferred : state.flushDeferred) = true;
+}
+
+
+void IoUringBackend::retryDeferred() {
+    if (acceptCancelDeferred) {
+        acceptCancelDeferred = false;
+        acceptPaused = false;
+        pauseAccept();
+    }
+
+    if (acceptDeferred && !acceptPaused && !acceptArmed) {
+        acceptDeferred = false;
+        queueAccept();
+    }
+
+    // 重试时可能再次推迟，先取出当前的列表。
+    vector<Connection*> conns;
+    conns.swap(deferred);
+
+    for (auto* conn : conns) {
+        auto& state = conn->ring;
+        bool recv = state.recvDeferred;
+        bool flushNow = state.flushDeferred;
+        state.recvDeferred = false;
+        state.flushDeferred = false;
+        state.pendingOps--;
+
+        if (recv && !state.recvPending && !state.closeQueued && !conn->closeAfterFlush) {
+            queueRecv(conn);
+        }
+
+        if (flushNow) {
+            flush(conn);
+        }
+
+        releaseIfDone(conn);
+    }
+}
+
+
+void IoUringBackend::queueAccept() {
+    auto* sqe = getSqe();
+    if (sqe == nullptr) {
+        acceptDeferred = true;
+        return;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd;
+    // 与 epoll 后端一致，连接设为非阻塞：OutputForwarder 会绕过 io_uring 直接 splice 到 fd，
+    // 而 SPLICE_F_NONBLOCK 只对管道一侧生效。io_uring 自身的收发不受 O_NONBLOCK 影响。
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    if (multishotAccept) {
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    }
+    sqe->user_data = OP_ACCEPT;
+
+    acceptArmed = true;
+}
+
+
+void IoUringBackend::queueRecv(Connection* conn) {
+    if (conn->ring.recvDeferred) {
+        return;
+    }
+
+    auto* sqe = getSqe();
+    if (sqe == nullptr) {
+        defer(conn, true);
+        return;
+    }
+
+    size_t len;
+    char* buf = server.prepareReceive(conn, len);
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->fd;
+    sqe->addr = (uint64_t) buf;
+    sqe->len = unsigned(min(len, size_t(INT_MAX)));
+    sqe->user_data = uint64_t(conn) | OP_RECV;
+
+    conn->ring.pendingOps++;
+    conn->ring.recvPending = true;
+}
+
+
+void IoUringBackend::queueClose(Connection* conn) {
+    auto* sqe = getSqe();
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = conn->fd;
+    sqe->user_data = uint64_t(conn) | OP_CLOSE;
+
+    conn->ring.pendingOps++;
+    conn->ring.closeQueued = true;
+}
+
+
+void IoUringBackend::flush(Connection* conn) {
+    auto& state = conn->ring;
+    if (state.closeQueued || state.sendPending || state.flushDeferred) {
+        return;  // 当前操作完成后会再次 flush
+    }
+
+    if (state.sending.empty() && conn->hasPendingOutput()) {
+        state.sending.swap(conn->out);
+    }
+
+    bool hasDataToSend = !state.sending.empty();
+    if (!hasDataToSend && !conn->closeAfterFlush) {
+        return;
+    }
+
+    int iovCount = 0;
+    size_t bytesToSend = 0;
+    if (hasDataToSend) {
+        iovCount = state.sending.fillIov(state.iov, Connection::RING_MAX_IOV);
+        for (int i = 0; i < iovCount; i++) {
+            bytesToSend += state.iov[i].iov_len;
+        }
+    }
+
+    bool closeAfterSend = conn->closeAfterFlush && !conn->hasPendingOutput()
+        && bytesToSend == state.sending.pendingBytes();
+
+    // cancel、send 与 close 必须一起入队，否则链接关系会被打乱。
+    unsigned sqes = (closeAfterSend && state.recvPending) + hasDataToSend + closeAfterSend;
+    if (!reserveSqes(sqes)) {
+        defer(conn, false);
+        return;
+    }
+
+    // 仍在等待的 recv 会一直持有 fd，需要先取消。
+    // 取消请求必须排在链接的 send-close 之前，否则会被并入链中。
+    if (closeAfterSend && state.recvPending) {
+        auto* sqe = getSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = uint64_t(conn) | OP_RECV;
+        sqe->user_data = uint64_t(conn) | OP_CANCEL;
+        state.pendingOps++;
+    }
+
+    if (hasDataToSend) {
+        memset(&state.msg, 0, sizeof(state.msg));
+        state.msg.msg_iov = state.iov;
+        state.msg.msg_iovlen = iovCount;
+
+        auto* sqe = getSqe();
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = conn->fd;
+        sqe->addr = (uint64_t) &state.msg;
+        sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+        sqe->user_data = uint64_t(conn) | OP_SEND;
+
+        state.pendingOps++;
+        state.sendPending = true;
+
+        if (closeAfterSend) {
+            // send 不完整或失败时，链上的 close 会以 -ECANCELED 完成，之后重新处理。
+            sqe->flags |= IOSQE_IO_LINK;
+            queueClose(conn);
+        }
+    } else if (closeAfterSend) {
+        queueClose(conn);
+    }
+
+    submitIfIdle();
+}
+
+
+void IoUringBackend::onCompletions() {
+    reaping = true;
+
+    // CQ 满过时，溢出的 CQE 在取空 CQ 后才能移回。
+    do {
+        while (auto* cqe = ring.peekCqe()) {
+            uint64_t userData = cqe->user_data;
+            int res = cqe->res;
+            uint32_t flags = cqe->flags;
+            ring.cqeSeen();
+
+            auto* conn = (Connection*) (userData & ~OP_MASK);
+            switch (userData & OP_MASK) {
+                case OP_ACCEPT:
+                    onAccept(res, flags);
+                    break;
+                case OP_RECV:
+                    onRecv(conn, res);
+                    break;
+                case OP_SEND:
+                    onSend(conn, res);
+                    break;
+                case OP_CLOSE:
+                    onClose(conn, res);
+                    break;
+                case OP_CANCEL:
+                    // 取消 accept 时没有对应的连接。
+                    if (conn != nullptr) {
+                        conn->ring.pendingOps--;
+                        releaseIfDone(conn);
+                    }
+                    break;
+                default:
+                    LOG_ERROR("unknown io_uring completion: ", userData);
+                    break;
+            }
+        }
+    } while (ring.flushOverflow());
+
+    retryDeferred();
+
+    reaping = false;
+    ring.submit();
+}
+
+
+void IoUringBackend::onAccept(int res, uint32_t flags) {
+    bool rearm = !(flags & IORING_CQE_F_MORE);
+    if (rearm) {
+        acceptArmed = false;
+    }
+
+    if (res == -EINVAL && multishotAccept) {
+        LOG_INFO("multishot accept not supported. falling back to single-shot accept.");
+        multishotAccept = false;
+        if (!acceptPaused) {
+            queueAccept();
+        }
+        return;
+    }
+
+    if (res < 0) {
+        if (res != -ECANCELED) {
+            LOG_WARN("socket connection failed.");
+        }
+    } else {
+        queueRecv(server.addConnection(res));
+    }
+
+    if (rearm && !acceptPaused) {
+        queueAccept();
+    }
+}
+
+
+void IoUringBackend::onRecv(Connection* conn, int res) {
+    auto& state = conn->ring;
+    state.pendingOps--;
+    state.recvPending = false;
+
+    if (state.closeQueued) {
+        releaseIfDone(conn);
+        return;
+    }
+
+    if (res > 0) {
+        server.onReceived(conn, res);
+        if (!conn->closeAfterFlush && !server.shouldPauseReceive(conn)) {
+            queueRecv(conn);
+        }
+    } else {
+        server.onReceiveFailed(conn, -res);
+    }
+
+    flush(conn);
+}
+
+
+void IoUringBackend::onSend(Connection* conn, int res) {
+    auto& state = conn->ring;
+    state.pendingOps--;
+    state.sendPending = false;
+
+    if (res < 0) {
+        // 对端已经断开。丢弃剩余数据，直接关闭。
+        conn->closeAfterFlush = true;
+        state.sending.clear();
+        conn->out.clear();
+    } else {
+        state.sending.consume(res);
+        server.onSent(conn);
+    }
+
+    flush(conn);
+
+    if (!state.sendPending && !conn->closeAfterFlush) {
+        server.onOutputDrained(conn);
+    }
+
+    // 因发送积压而暂停的接收，在此恢复。
+    if (!state.recvPending && !state.closeQueued && !conn->closeAfterFlush
+        && !server.shouldPauseReceive(conn)
+    ) {
+        queueRecv(conn);
+    }
+}
+
+
+void IoUringBackend::onClose(Connection* conn, int res) {
+    auto& state = conn->ring;
+    state.pendingOps--;
+
+    if (res == -ECANCELED) {
+        // 链接的 send 未完整发送。先把剩余数据发完再关闭。
+        state.closeQueued = false;
+        flush(conn);
+        return;
+    }
+
+    conn->fd = -1;
+    releaseIfDone(conn);
+}
+
+
+void IoUringBackend::releaseIfDone(Connection* conn) {
+    if (conn->fd == -1 && conn->ring.pendingOps == 0) {
+        server.removeConnection(conn);
+    }
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 io_uring 的 I/O 后端
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "./IoBackend.h"
+#include "./IoUring.h"
+
+namespace vl {
+namespace server {
+
+/**
+ * 使用 multishot accept、批量提交的 recv，以及 send 后链接 close 的方式服务连接。
+ *
+ * ring fd 注册在 EventLoop 上：CQ 非空时 ring fd 可读，由事件循环回调收割完成事件。
+ * 一轮收割中产生的所有新请求在最后用一次 io_uring_enter 提交。
+ * 提交失败（如 CQ 溢出时的 EBUSY）导致 SQ 已满时，请求推迟到下一轮收割后重试。
+ */
+class IoUringBackend : public IoBackend {
+public:
+    using IoBackend::IoBackend;
+
+    virtual int start(int listenFd) override;
+    virtual void pauseAccept() override;
+    virtual int resumeAccept(int listenFd) override;
+    virtual void flush(Connection* conn) override;
+    virtual const char* name() const override { return "io-uring"; }
+
+protected:
+    enum Op : uint64_t {
+        OP_ACCEPT = 1,
+        OP_RECV = 2,
+        OP_SEND = 3,
+        OP_CLOSE = 4,
+        OP_CANCEL = 5,
+    };
+
+    static const uint64_t OP_MASK = 0x7;
+
+    /**
+     * 取一个 SQE。SQ 已满时先提交一次；仍然没有空闲时返回 nullptr。
+     */
+    io_uring_sqe* getSqe();
+
+    /**
+     * 确保 SQ 中至少还能取出 n 个 SQE。
+     */
+    bool reserveSqes(unsigned n);
+
+    void submitIfIdle();
+
+    /**
+     * 推迟 conn 上的 recv 或 flush。
+     */
+    void defer(Connection* conn, bool recv);
+
+    /**
+     * 重试推迟的请求。
+     */
+    void retryDeferred();
+
+    void queueAccept();
+    void queueRecv(Connection* conn);
+    void queueClose(Connection* conn);
+
+    void onCompletions();
+    void onAccept(int res, uint32_t flags);
+    void onRecv(Connection* conn, int res);
+    void onSend(Connection* conn, int res);
+    void onClose(Connection* conn, int res);
+
+    /** 所有操作完成、fd 已关闭后，释放连接。 */
+    void releaseIfDone(Connection* conn);
+
+    IoUring ring;
+    int listenFd = -1;
+    bool multishotAccept = true;
+
+    /** 有未结束的 accept 请求。 */
+    bool acceptArmed = false;
+
+    bool acceptPaused = false;
+
+    /** 因 SQ 已满而推迟的 accept 与取消 accept。 */
+    bool acceptDeferred = false;
+    bool acceptCancelDeferred = false;
+
+    /** 有推迟请求的连接。 */
+    std::vector<Connection*> deferred;
+
+    /** 正在收割完成事件。此时不立即提交，留到本轮结束后统一提交。 */
+    bool reaping = false;
+};
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,502 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 把子进程的 stdout/stderr 转发给 client
+ * 创建于 2026年10月17日
+ */
+
+#include "./OutputForwarder.h"
+#include "../Protocols.h"
+#include "../Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+/** 单个 chunk 的最大数据量。与默认的管道容量相同。 */
+static const size_t MAX_CHUNK = 64 * 1024;
+
+/** 连接积压超过该值时，暂停读取输出管道。 */
+static const size_t MAX_BACKLOG = 1024 * 1024;
+
+/** OutputChunk 中 data 之前的部分：header、pid、stream 与 data 长度。 */
+static const size_t CHUNK_PREFIX_LEN = protocol::HEADER_LEN + protocol::OutputChunk::Fields::minSize;
+
+
+static void writeChunkPrefix(char* p, pid_t pid, uint32_t stream, uint32_t len) {
+    memcpy(p, protocol::MAGIC_STR, 4);
+    p = protocol::writeBE32(p + 4, protocol::OutputChunk::typeCode);
+    p = protocol::writeBE64(p, protocol::OutputChunk::Fields::minSize + len);
+    p = protocol::writeBE(p, int32_t(pid));
+    p = protocol::writeBE32(p, stream);
+    protocol::writeBE32(p, len);
+}
+
+
+OutputForwarder::~OutputForwarder() {
+    shutdown();
+}
+
+
+int OutputForwarder::init(EventLoop& loop, FlushCallback onFlush, IdleCallback onIdle) {
+    this->loop = &loop;
+    this->onFlush = onFlush;
+    this->onIdle = onIdle;
+
+    devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (devNull < 0) {
+        LOG_ERROR("failed to open /dev/null: ", strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+int OutputForwarder::enableLogCapture(
+    const string& dir, const RotatingLog::Options& options, int sessions
+) {
+    if (mkdir(dir.c_str(), 0700) < 0 && errno != EEXIST) {
+        LOG_ERROR("failed to create log directory ", dir, ": ", strerror(errno));
+        return -1;
+    }
+
+    logDirFd = open(dir.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (logDirFd < 0) {
+        LOG_ERROR("failed to open log directory ", dir, ": ", strerror(errno));
+        return -1;
+    }
+
+    // 中转管道不能小于单个 chunk，否则 tee 一次复制不完。
+    if (pipe2(teePipe, O_CLOEXEC | O_NONBLOCK) < 0
+        || fcntl(teePipe[1], F_SETPIPE_SZ, int(MAX_CHUNK)) < int(MAX_CHUNK)
+    ) {
+        LOG_ERROR("failed to create tee pipe: ", strerror(errno));
+        close(logDirFd);
+        logDirFd = -1;
+        return -1;
+    }
+
+    logOptions = options;
+    maxLogSessions = size_t(max(sessions, 1));
+    loadLogSessions(dir);
+
+    return 0;
+}
+
+
+/**
+ * 解析 <启动时间>-<pid>-std(out|err).log[.N] 形式的文件名。
+ *
+ * @return 会话名的长度。不是日志文件时返回 0。
+ */
+static size_t parseLogFileName(const char* name, pid_t& pid) {
+    char* end;
+    strtoull(name, &end, 10);
+    if (end == name || *end != '-') {
+        return 0;
+    }
+
+    char* pidStart = end + 1;
+    long value = strtol(pidStart, &end, 10);
+    if (end == pidStart || value <= 0) {
+        return 0;
+    }
+
+    if (strncmp(end, "-stdout.log", 11) != 0 && strncmp(end, "-stderr.log", 11) != 0) {
+        return 0;
+    }
+
+    pid = pid_t(value);
+    return size_t(end - name);
+}
+
+
+void OutputForwarder::loadLogSessions(const string& dir) {
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        LOG_WARN("failed to list log directory ", dir, ": ", strerror(errno));
+        return;
+    }
+
+    // 时间戳位数相同，按名称排序即按时间排序。
+    vector<LogSession> found;
+    while (auto* ent = readdir(d)) {
+        pid_t pid;
+        size_t len = parseLogFileName(ent->d_name, pid);
+        if (len) {
+            found.push_back({ string(ent->d_name, len), pid });
+        }
+    }
+    closedir(d);
+
+    sort(found.begin(), found.end(), [] (const LogSession& a, const LogSession& b) {
+        return a.name < b.name;
+    });
+
+    for (auto& it : found) {
+        if (logSessions.empty() || logSessions.back().name != it.name) {
+            logSessions.push_back(std::move(it));
+        }
+    }
+}
+
+
+void OutputForwarder::addLogSession(string session, pid_t pid) {
+    logSessions.push_back({ std::move(session), pid });
+
+    // 仍在写入的会话不删除，跳过它们，删除更新一些的已结束会话。
+    auto it = logSessions.begin();
+    while (logSessions.size() > maxLogSessions && it != logSessions.end()) {
+        bool active = false;
+        for (auto& s : streams) {
+            if (s.first->log && s.first->pid == it->pid) {
+                active = true;
+                break;
+            }
+        }
+
+        if (active) {
+            ++it;
+            continue;
+        }
+
+        const char* kinds[] = { "-stdout.log", "-stderr.log" };
+        for (auto* kind : kinds) {
+            string name = it->name + kind;
+            for (int i = 0; i < logOptions.segments; i++) {
+                string file = i == 0 ? name : name + "." + to_string(i);
+                if (unlinkat(logDirFd, file.c_str(), 0) < 0 && errno != ENOENT) {
+                    LOG_WARN("failed to remove log file ", file, ": ", strerror(errno));
+                }
+            }
+        }
+
+        it = logSessions.erase(it);
+    }
+}
+
+
+int OutputForwarder::prepare(uint32_t live, spawn::LaunchParams& params) {
+    const uint32_t kinds[] = {
+        protocol::OutputChunk::STREAM_STDOUT, protocol::OutputChunk::STREAM_STDERR
+    };
+
+    for (auto kind : kinds) {
+        if (!(live & kind) && !capturingLogs()) {
+            continue;
+        }
+
+        // 只有读端是非阻塞的：子进程写满管道时应当阻塞，而不是收到 EAGAIN。
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) < 0) {
+            int err = errno;
+            LOG_ERROR("failed to create output pipe: ", strerror(err));
+            commit(-1, nullptr);
+            return -err;
+        }
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+        pending.push_back({ kind, fds[0], fds[1], (live & kind) != 0 });
+
+        if (kind == protocol::OutputChunk::STREAM_STDOUT) {
+            params.stdoutFd = fds[1];
+        } else {
+            params.stderrFd = fds[1];
+        }
+    }
+
+    // 只写日志时，认领预热池中的实例更重要。此时管道没有写者，随即结束。
+    params.optionalStdio = live == 0;
+
+    return 0;
+}
+
+
+void OutputForwarder::commit(pid_t pid, Connection* conn) {
+    string session;
+    if (pid >= 0 && !pending.empty() && capturingLogs()) {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        session = to_string(int64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000);
+        session += '-';
+        session += to_string(pid);
+    }
+
+    for (auto& it : pending) {
+        close(it.writeFd);
+
+        if (pid < 0) {
+            close(it.readFd);
+            continue;
+        }
+
+        auto stream = make_unique<Stream>();
+        auto* s = stream.get();
+        s->fd = it.readFd;
+        s->pid = pid;
+        s->stream = it.stream;
+        s->conn = it.live ? conn : nullptr;
+        streams[s] = std::move(stream);
+
+        if (it.live) {
+            conn->outputStreams++;
+        }
+
+        if (capturingLogs()) {
+            string name = session;
+            name += it.stream == protocol::OutputChunk::STREAM_STDOUT ? "-stdout.log" : "-stderr.log";
+            s->log = make_unique<RotatingLog>(logDirFd, std::move(name), logOptions);
+        }
+
+        loop->add(s->fd, EPOLLIN, [this, s] (uint32_t events) {
+            onReadable(s, events);
+        });
+    }
+
+    pending.clear();
+
+    if (!session.empty()) {
+        addLogSession(std::move(session), pid);
+    }
+}
+
+
+void OutputForwarder::detach(Connection* conn) {
+    for (auto& it : streams) {
+        auto* s = it.first;
+        if (s->conn != conn) {
+            continue;
+        }
+
+        s->conn = nullptr;
+        if (s->paused) {
+            resume(s);
+        }
+    }
+}
+
+
+void OutputForwarder::onDrained(Connection* conn) {
+    for (auto& it : streams) {
+        auto* s = it.first;
+        if (s->paused && s->conn == conn) {
+            resume(s);
+        }
+    }
+}
+
+
+void OutputForwarder::resume(Stream* s) {
+    s->paused = false;
+    loop->add(s->fd, EPOLLIN, [this, s] (uint32_t events) {
+        onReadable(s, events);
+    });
+}
+
+
+void OutputForwarder::shutdown() {
+    commit(-1, nullptr);
+
+    for (auto& it : streams) {
+        auto* s = it.first;
+
+        int avail = 0;
+        if (s->log && ioctl(s->fd, FIONREAD, &avail) == 0 && avail > 0) {
+            drain(s, size_t(avail));
+        }
+
+        if (!s->paused) {
+            loop->remove(s->fd);
+        }
+        close(s->fd);
+    }
+    streams.clear();
+
+    if (devNull >= 0) {
+        close(devNull);
+        devNull = -1;
+    }
+
+    if (logDirFd >= 0) {
+        close(logDirFd);
+        close(teePipe[0]);
+        close(teePipe[1]);
+        logDirFd = -1;
+    }
+}
+
+
+void OutputForwarder::onReadable(Stream* s, uint32_t events) {
+    if (s->conn && s->conn->backlog() > MAX_BACKLOG) {
+        // 管道写端关闭后 epoll 总会报告 EPOLLHUP，因此不能只清空关注的事件。
+        loop->remove(s->fd);
+        s->paused = true;
+        return;
+    }
+
+    int avail = 0;
+    if (ioctl(s->fd, FIONREAD, &avail) < 0 || avail <= 0) {
+        if (events & (EPOLLHUP | EPOLLERR)) {
+            finish(s);
+        }
+        return;
+    }
+
+    // 每次只处理一个 chunk。事件循环是水平触发的，剩余数据下一轮再处理。
+    size_t len = min(size_t(avail), MAX_CHUNK);
+    if (s->conn) {
+        forward(s, len);
+    } else {
+        drain(s, len);
+    }
+}
+
+
+void OutputForwarder::forward(Stream* s, size_t len) {
+    auto* conn = s->conn;
+
+    if (s->log) {
+        teeToLog(s, len);
+    }
+
+    char prefix[CHUNK_PREFIX_LEN];
+    writeChunkPrefix(prefix, s->pid, s->stream, uint32_t(len));
+
+    size_t prefixSent = 0;
+    size_t dataSent = 0;
+
+    if (conn->canWriteDirectly()) {
+        ssize_t n = send(conn->fd, prefix, sizeof(prefix), MSG_DONTWAIT | MSG_NOSIGNAL | MSG_MORE);
+        prefixSent = n > 0 ? size_t(n) : 0;
+
+        if (prefixSent == sizeof(prefix)) {
+            ssize_t m = splice(
+                s->fd, nullptr, conn->fd, nullptr, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK
+            );
+            dataSent = m > 0 ? size_t(m) : 0;
+        }
+
+        if (dataSent == len) {
+            return;
+        }
+    }
+
+    // socket 暂时写不下，剩余部分读入发送队列。数据仍在管道中，按顺序接在已发出的部分之后。
+    size_t prefixLeft = sizeof(prefix) - prefixSent;
+    size_t dataLeft = len - dataSent;
+
+    char* p = conn->out.reserve(prefixLeft + dataLeft);
+    memcpy(p, prefix + prefixSent, prefixLeft);
+    p += prefixLeft;
+
+    size_t got = 0;
+    while (got < dataLeft) {
+        ssize_t n = read(s->fd, p + got, dataLeft - got);
+        if (n > 0) {
+            got += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+
+    // FIONREAD 报告的数据只有这里会读，不应读不满。万一发生，补 0 以保持报文完整。
+    if (got < dataLeft) {
+        LOG_WARN("output pipe of pid ", s->pid, " returned less data than expected.");
+        memset(p + got, 0, dataLeft - got);
+    }
+
+    onFlush(conn);
+}
+
+
+void OutputForwarder::teeToLog(Stream* s, size_t len) {
+    ssize_t n = tee(s->fd, teePipe[1], len, SPLICE_F_NONBLOCK);
+    if (n <= 0) {
+        return;
+    }
+
+    // 中转管道必须清空，否则残留数据会混进下一个流的日志。
+    size_t moved = s->log->spliceFrom(teePipe[0], n);
+    if (moved < size_t(n)) {
+        discard(teePipe[0], n - moved);
+    }
+}
+
+
+void OutputForwarder::drain(Stream* s, size_t len) {
+    size_t moved = s->log ? s->log->spliceFrom(s->fd, len) : 0;
+    if (moved < len) {
+        discard(s->fd, len - moved);
+    }
+}
+
+
+void OutputForwarder::discard(int fd, size_t len) {
+    while (len > 0) {
+        ssize_t n = splice(fd, nullptr, devNull, nullptr, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            len -= n;
+            continue;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n == 0 || errno == EAGAIN) {
+            return;
+        }
+
+        // 不支持 splice 时退回到 read。
+        static char buf[4096];
+        n = read(fd, buf, min(len, sizeof(buf)));
+        if (n <= 0) {
+            return;
+        }
+        len -= n;
+    }
+}
+
+
+void OutputForwarder::finish(Stream* s) {
+    auto* conn = s->conn;
+
+    if (conn) {
+        static protocol::OutputChunk eof;
+        eof.pid = s->pid;
+        eof.stream = s->stream;
+        eof.data = {};
+        conn->send(eof);
+        conn->outputStreams--;
+    }
+
+    if (!s->paused) {
+        loop->remove(s->fd);
+    }
+    close(s->fd);
+    streams.erase(s);
+
+    if (conn) {
+        onFlush(conn);
+    }
+
+    if (streams.empty()) {
+        onIdle();
+    }
+}
+
+} // namespace server
+} // namespace vl
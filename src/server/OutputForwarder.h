@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 把子进程的 stdout/stderr 转发给 client
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "./Connection.h"
+#include "./EventLoop.h"
+#include "./RotatingLog.h"
+#include "../spawn/Launcher.h"
+
+namespace vl {
+namespace server {
+
+/**
+ * 为启动的子进程创建输出管道，把读到的数据以 protocol::OutputChunk 发给请求的连接，
+ * 并在启用日志捕获时写入日志文件。
+ *
+ * 连接没有积压时，chunk 的数据用 splice 从管道直接移到 socket，不经过用户态；
+ * 否则读入连接的发送队列，由 I/O 后端发出。
+ * 连接积压过多时暂停读取管道，子进程写满管道后会阻塞，直到积压排空。
+ * 连接关闭后，剩余输出只写入日志（或 splice 到 /dev/null 丢弃），子进程不会因此收到 SIGPIPE。
+ * 服务端退出前应等到 idle()，即子进程关闭了全部输出管道；shutdown() 关闭读端后，
+ * 仍在写入的子进程会收到 SIGPIPE。
+ *
+ * 同时需要转发与写日志时，先用 tee 把数据复制到一个中转管道，再 splice 进日志文件。
+ */
+class OutputForwarder {
+public:
+    /**
+     * 连接上有待发送的数据，或该连接上的某个输出流已结束。
+     */
+    using FlushCallback = std::function<void (Connection* conn)>;
+
+    /**
+     * 全部输出流都已结束。
+     */
+    using IdleCallback = std::function<void ()>;
+
+    OutputForwarder() = default;
+    ~OutputForwarder();
+
+    OutputForwarder(const OutputForwarder&) = delete;
+    OutputForwarder& operator = (const OutputForwarder&) = delete;
+
+    /**
+     * @return 成功时返回 0。
+     */
+    int init(EventLoop& loop, FlushCallback onFlush, IdleCallback onIdle);
+
+    /**
+     * 把之后启动的每个子进程的 stdout 与 stderr 写入 dir 下的日志文件，
+     * 文件名为 <启动时间>-<pid>-stdout.log 与 <启动时间>-<pid>-stderr.log，
+     * 启动时间为 Unix 毫秒时间戳。pid 被复用时不会覆盖之前的日志。dir 不存在时创建。
+     *
+     * @param sessions 目录中最多保留多少个子进程的日志（含之前运行留下的）。
+     *                 超出时删除最旧的、已结束的子进程的日志。
+     * @return 成功时返回 0。
+     */
+    int enableLogCapture(const std::string& dir, const RotatingLog::Options& options, int sessions);
+
+    bool capturingLogs() const { return logDirFd >= 0; }
+
+    /**
+     * 为一次启动创建管道，写端填入 params。
+     * 启用日志捕获时，总会为 stdout 与 stderr 创建管道。
+     * 之后必须调用 commit()。
+     *
+     * @param live 需要转发给连接的输出流。protocol::OutputChunk::STREAM_* 的组合。
+     *
+     * @return 成功时返回 0，否则返回 -errno。
+     */
+    int prepare(uint32_t live, spawn::LaunchParams& params);
+
+    /**
+     * 关闭 prepare() 给出的写端。启动成功时开始转发，否则关闭读端。
+     *
+     * @param pid 启动结果。为负表示启动失败。
+     */
+    void commit(pid_t pid, Connection* conn);
+
+    /**
+     * 连接即将释放。之后该连接上的输出流被丢弃。
+     */
+    void detach(Connection* conn);
+
+    /**
+     * 连接的发送队列已排空。恢复因积压暂停的输出流。
+     */
+    void onDrained(Connection* conn);
+
+    /**
+     * 没有未结束的输出流。
+     */
+    bool idle() const { return streams.empty(); }
+
+    /**
+     * 关闭全部输出流。管道中已有的数据先写入日志。
+     */
+    void shutdown();
+
+protected:
+    struct Stream {
+        int fd;
+        pid_t pid;
+        uint32_t stream;
+
+        /** 为 nullptr 时不转发。 */
+        Connection* conn;
+
+        /** 为 nullptr 时不写日志。 */
+        std::unique_ptr<RotatingLog> log;
+
+        /** 因连接积压暂停读取。 */
+        bool paused = false;
+    };
+
+    void onReadable(Stream* s, uint32_t events);
+
+    /**
+     * 重新开始读取暂停的输出流。
+     */
+    void resume(Stream* s);
+
+    /**
+     * 把管道中 len 字节作为一个 chunk 发出。
+     */
+    void forward(Stream* s, size_t len);
+
+    /**
+     * 把管道开头的 len 字节复制进日志，不从管道中取走。
+     */
+    void teeToLog(Stream* s, size_t len);
+
+    /**
+     * 从管道取走 len 字节，写入日志或丢弃。
+     */
+    void drain(Stream* s, size_t len);
+
+    /**
+     * 从 fd 取走 len 字节并丢弃。
+     */
+    void discard(int fd, size_t len);
+
+    /**
+     * 发送 EOF 标记并关闭输出流。调用后 s 失效。
+     */
+    void finish(Stream* s);
+
+    /**
+     * 记录一个新的日志会话，并删除超出数量的旧会话。
+     */
+    void addLogSession(std::string session, pid_t pid);
+
+    /**
+     * 读取日志目录中已有的会话。
+     */
+    void loadLogSessions(const std::string& dir);
+
+    EventLoop* loop = nullptr;
+    FlushCallback onFlush;
+    IdleCallback onIdle;
+    int devNull = -1;
+
+    int logDirFd = -1;
+    RotatingLog::Options logOptions;
+
+    /** 日志会话，即一个子进程的全部日志文件，由旧到新排列。 */
+    struct LogSession {
+        /** 文件名中 -stdout.log 之前的部分。 */
+        std::string name;
+        pid_t pid;
+    };
+    std::deque<LogSession> logSessions;
+    size_t maxLogSessions = 0;
+
+    /** tee 的中转管道。 */
+    int teePipe[2] = { -1, -1 };
+
+    std::unordered_map<Stream*, std::unique_ptr<Stream>> streams;
+
+    /** prepare() 创建、尚未 commit() 的管道。 */
+    struct Pending {
+        uint32_t stream;
+        int readFd;
+        int writeFd;
+
+        /** 是否转发给连接。 */
+        bool live;
+    };
+    std::vector<Pending> pending;
+};
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 连接的发送队列
+ * 创建于 2026年10月17日
+ */
+
+#include "./OutputQueue.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+char* OutputQueue::reserve(size_t n) {
+    size_t offset = buf.size();
+    buf.resize(offset + n);
+
+    // 与上一个内部段相邻时直接合并。
+    if (!segments.empty()) {
+        auto& last = segments.back();
+        if (last.external == nullptr && last.offset + last.len == offset) {
+            last.len += n;
+            pending += n;
+            return buf.data() + offset;
+        }
+    }
+
+    segments.push_back({ nullptr, offset, n });
+    pending += n;
+    return buf.data() + offset;
+}
+
+
+void OutputQueue::unreserve(size_t n) {
+    auto& last = segments.back();
+    last.len -= n;
+    buf.resize(buf.size() - n);
+    pending -= n;
+
+    if (last.len == 0) {
+        segments.pop_back();
+    }
+}
+
+
+void OutputQueue::reference(const char* data, size_t len) {
+    if (len == 0) {
+        return;
+    }
+
+    segments.push_back({ data, 0, len });
+    pending += len;
+}
+
+
+int OutputQueue::fillIov(iovec* iov, int maxIov) const {
+    int count = 0;
+    for (size_t i = headSegment; i < segments.size() && count < maxIov; i++) {
+        auto& seg = segments[i];
+        const char* base = seg.external ? seg.external : buf.data() + seg.offset;
+        size_t skip = (i == headSegment) ? headOffset : 0;
+
+        iov[count].iov_base = (void*) (base + skip);
+        iov[count].iov_len = seg.len - skip;
+        count++;
+    }
+
+    return count;
+}
+
+
+void OutputQueue::consume(size_t bytes) {
+    pending -= bytes;
+
+    while (bytes > 0) {
+        size_t left = segments[headSegment].len - headOffset;
+        if (bytes < left) {
+            headOffset += bytes;
+            return;
+        }
+
+        bytes -= left;
+        headSegment++;
+        headOffset = 0;
+    }
+
+    if (pending == 0) {
+        clear();
+    } else {
+        compact();
+    }
+}
+
+
+void OutputQueue::compact() {
+    if (headSegment * 2 > segments.size()) {
+        segments.erase(segments.begin(), segments.begin() + headSegment);
+        headSegment = 0;
+    }
+
+    // 内部段按 offset 递增排列。第一个未发完的内部段之前的数据都已发送。
+    size_t start = buf.size();
+    for (size_t i = headSegment; i < segments.size(); i++) {
+        if (segments[i].external == nullptr) {
+            start = segments[i].offset;
+            break;
+        }
+    }
+
+    size_t tail = buf.size() - start;
+    if (start == 0 || start < tail) {
+        return;
+    }
+
+    memmove(buf.data(), buf.data() + start, tail);
+    buf.resize(tail);
+    for (size_t i = headSegment; i < segments.size(); i++) {
+        if (segments[i].external == nullptr) {
+            segments[i].offset -= start;
+        }
+    }
+}
+
+
+void OutputQueue::clear() {
+    buf.clear();
+    segments.clear();
+    headSegment = 0;
+    headOffset = 0;
+    pending = 0;
+}
+
+
+void OutputQueue::swap(OutputQueue& other) {
+    buf.swap(other.buf);
+    segments.swap(other.segments);
+    std::swap(headSegment, other.headSegment);
+    std::swap(headOffset, other.headOffset);
+    std::swap(pending, other.pending);
+}
+
+} // namespace server
+} // namespace vl
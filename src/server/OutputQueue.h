@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 连接的发送队列
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "../Protocols.h"
+
+namespace vl {
+namespace server {
+
+/**
+ * 待发送数据队列。
+ *
+ * 由若干段组成：一部分存放在队列自己的缓冲中（报文 header 与定长字段），
+ * 另一部分直接引用外部数据。发送时通过 fillIov() 得到 iovec 数组，交给 writev/sendmsg。
+ * 清空后保留已分配的内存，稳定运行时不需要再次分配。
+ * 队列一直没有完全排空时（如持续转发输出），已发送的部分超过未发送的部分后被移除，
+ * 缓冲的长度不会无限增长。
+ */
+class OutputQueue : public protocol::Encoder {
+public:
+    virtual char* reserve(size_t n) override;
+    virtual void reference(const char* data, size_t len) override;
+
+    /**
+     * 退回最近一次 reserve() 末尾未使用的 n 字节。
+     */
+    void unreserve(size_t n);
+
+    bool empty() const { return pending == 0; }
+    size_t pendingBytes() const { return pending; }
+
+    /**
+     * 用尚未发送的数据填充 iov。
+     *
+     * @return 填充的 iovec 数量。
+     */
+    int fillIov(iovec* iov, int maxIov) const;
+
+    /**
+     * 标记开头的 bytes 字节已发送。
+     */
+    void consume(size_t bytes);
+
+    void clear();
+
+    void swap(OutputQueue& other);
+
+protected:
+    /**
+     * 移除已发送的段，并把未发送的内部数据移到缓冲开头。
+     * 已发送的部分不超过剩余部分时不做处理，移动的总量与发送量成正比。
+     */
+    void compact();
+
+    struct Segment {
+        /** 为 nullptr 时，数据位于 buf[offset, offset + len)。 */
+        const char* external;
+        size_t offset;
+        size_t len;
+    };
+
+    std::vector<char> buf;
+    std::vector<Segment> segments;
+
+    /** 第一个尚未发完的段，以及该段中已发送的字节数。 */
+    size_t headSegment = 0;
+    size_t headOffset = 0;
+
+    size_t pending = 0;
+};
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 从 /proc 采集进程资源用量
+ * 创建于 2026年10月17日
+ */
+
+#include "./ProcessSampler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+/**
+ * 读取 dirFd 下的小文件到 buf，并以 0 结尾。
+ *
+ * @return 读到的字节数。失败时返回负数。
+ */
+static ssize_t readProcFile(int dirFd, const char* name, char* buf, size_t size) {
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+
+    if (n < 0) {
+        return -1;
+    }
+
+    buf[n] = '\0';
+    return n;
+}
+
+
+static uint64_t ticksToMicros(uint64_t ticks) {
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    return ticks * 1000000 / uint64_t(ticksPerSecond);
+}
+
+
+int openProcessDir(int pid) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d", pid);
+    return open(path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+}
+
+
+int sampleProcess(int procDirFd, ProcessSample& sample) {
+    char buf[1024];
+
+    /* stat */
+
+    if (readProcFile(procDirFd, "stat", buf, sizeof(buf)) <= 0) {
+        sample.state = '?';
+        return -1;
+    }
+
+    // comm 可能包含空格与括号，从最后一个 ')' 之后开始解析。
+    char* p = strrchr(buf, ')');
+    if (p == nullptr || p[1] != ' ') {
+        return -1;
+    }
+    p += 2;
+
+    sample.state = *p;
+
+    // 之后依次是 state(3) ppid(4) ... utime(14) stime(15)。
+    for (int field = 3; field < 14 && p; field++) {
+        p = strchr(p, ' ');
+        if (p) {
+            p++;
+        }
+    }
+    if (p == nullptr) {
+        return -1;
+    }
+
+    char* end;
+    sample.userTime = ticksToMicros(strtoull(p, &end, 10));
+    sample.systemTime = ticksToMicros(strtoull(end, &end, 10));
+
+    /* statm */
+
+    static const long pageKiB = sysconf(_SC_PAGESIZE) / 1024;
+    if (readProcFile(procDirFd, "statm", buf, sizeof(buf)) > 0) {
+        strtoull(buf, &end, 10);  // size
+        sample.rss = strtoull(end, nullptr, 10) * pageKiB;
+    }
+
+    /* io */
+
+    if (readProcFile(procDirFd, "io", buf, sizeof(buf)) > 0) {
+        if (char* q = strstr(buf, "\nread_bytes: ")) {
+            sample.readBytes = strtoull(q + 13, nullptr, 10);
+        }
+        if (char* q = strstr(buf, "\nwrite_bytes: ")) {
+            sample.writeBytes = strtoull(q + 14, nullptr, 10);
+        }
+    }
+
+    sample.sampledAt = monotonicMicros();
+
+    return 0;
+}
+
+
+uint64_t monotonicMicros() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+} // namespace server
+} // namespace vl
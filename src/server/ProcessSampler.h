@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 从 /proc 采集进程资源用量
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace vl {
+namespace server {
+
+struct ProcessSample {
+    /** /proc/<pid>/stat 中的状态字符，如 'R'、'S'。采集失败时为 '?'。 */
+    char state = '?';
+
+    /** CPU 时间。单位为微秒。 */
+    uint64_t userTime = 0;
+    uint64_t systemTime = 0;
+
+    /** 常驻内存。单位为 KiB。 */
+    uint64_t rss = 0;
+
+    /** 实际读写存储设备的字节数。 */
+    uint64_t readBytes = 0;
+    uint64_t writeBytes = 0;
+
+    /** 采集时刻（CLOCK_MONOTONIC）。单位为微秒。 */
+    uint64_t sampledAt = 0;
+};
+
+
+/**
+ * 打开 /proc/<pid> 目录，供 sampleProcess() 反复使用。
+ * 目录 fd 固定指向该进程，pid 被复用后读取会失败，不会读到其他进程。
+ *
+ * @return 目录 fd。失败时返回 -1。
+ */
+int openProcessDir(int pid);
+
+/**
+ * 读取 stat、statm 与 io。
+ *
+ * @return 成功时返回 0。进程已退出时返回负数。
+ */
+int sampleProcess(int procDirFd, ProcessSample& sample);
+
+/**
+ * CLOCK_MONOTONIC 当前时刻。单位为微秒。
+ */
+uint64_t monotonicMicros();
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 按大小轮转的日志文件
+ * 创建于 2026年10月17日
+ */
+
+#include "./RotatingLog.h"
+#include "../Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+RotatingLog::RotatingLog(int dirFd, string name, const Options& options) {
+    this->dirFd = dirFd;
+    this->name = std::move(name);
+    this->options = options;
+}
+
+
+RotatingLog::~RotatingLog() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+
+size_t RotatingLog::spliceFrom(int pipeFd, size_t len) {
+    size_t moved = 0;
+
+    while (moved < len && !failed) {
+        if (fd < 0) {
+            // splice 不支持 O_APPEND 打开的文件。
+            fd = openat(dirFd, name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (fd < 0) {
+                LOG_ERROR("failed to open log file ", name, ": ", strerror(errno));
+                failed = true;
+                break;
+            }
+            size = 0;
+        }
+
+        size_t room = options.maxSize - size;
+        ssize_t n = splice(pipeFd, nullptr, fd, nullptr, min(len - moved, room), SPLICE_F_MOVE);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("failed to write log file ", name, ": ", n < 0 ? strerror(errno) : "EOF");
+            failed = true;
+            break;
+        }
+
+        moved += n;
+        size += n;
+
+        if (size >= options.maxSize) {
+            rotate();
+        }
+    }
+
+    return moved;
+}
+
+
+void RotatingLog::rotate() {
+    close(fd);
+    fd = -1;
+
+    if (options.segments <= 1) {
+        return;  // 下次打开时截断。
+    }
+
+    // name.(segments-2) -> name.(segments-1) ... name -> name.1。最旧的一个被覆盖。
+    string from;
+    string to = name + "." + to_string(options.segments - 1);
+    for (int i = options.segments - 2; i >= 0; i--) {
+        from = i == 0 ? name : name + "." + to_string(i);
+        if (renameat(dirFd, from.c_str(), dirFd, to.c_str()) < 0 && errno != ENOENT) {
+            LOG_WARN("failed to rotate log file ", from, ": ", strerror(errno));
+        }
+        to.swap(from);
+    }
+}
+
+} // namespace server
+} // namespace vl
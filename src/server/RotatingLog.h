@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 按大小轮转的日志文件
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <sys/types.h>
+
+namespace vl {
+namespace server {
+
+/**
+ * 把管道中的数据 splice 进日志文件。
+ *
+ * 当前文件为 name，写满 maxSize 后依次改名为 name.1、name.2……
+ * 最多保留 segments 个文件（含当前文件），更旧的被删除。
+ * 文件在第一次写入时才创建。
+ */
+class RotatingLog {
+public:
+    struct Options {
+        /** 单个文件的最大长度。单位为 Byte。 */
+        size_t maxSize = 1024 * 1024;
+
+        /** 保留的文件数，含正在写的文件。 */
+        int segments = 4;
+    };
+
+    /**
+     * @param dirFd 日志所在目录。由调用者持有，需比本对象存活更久。
+     */
+    RotatingLog(int dirFd, std::string name, const Options& options);
+    ~RotatingLog();
+
+    RotatingLog(const RotatingLog&) = delete;
+    RotatingLog& operator = (const RotatingLog&) = delete;
+
+    /**
+     * 从管道 pipeFd 移入 len 字节。调用者需保证管道中至少有 len 字节。
+     *
+     * @return 移入的字节数。出错时可能小于 len，剩余数据留在管道中。
+     */
+    size_t spliceFrom(int pipeFd, size_t len);
+
+protected:
+    /**
+     * 关闭当前文件并轮转。下次写入时重新创建。
+     */
+    void rotate();
+
+    int dirFd;
+    std::string name;
+    Options options;
+
+    int fd = -1;
+    size_t size = 0;
+
+    /** 出错后不再写入，避免每个 chunk 都打印一遍错误。 */
+    bool failed = false;
+};
+
+} // namespace server
+} // namespace vl
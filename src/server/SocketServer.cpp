@@ -0,0 +1,611 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * domain socket 服务端
+ * 创建于 2026年10月17日
+ */
+
+#include "./SocketServer.h"
+#include "./Dispatcher.h"
+#include "./EpollBackend.h"
+#include "./IoUringBackend.h"
+#include "../Protocols.h"
+#include "../Log.h"
+#include "../Trace.h"
+
+#include <cerrno>
+#include <cstring>
+#include <cstddef>
+
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/un.h>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+int SocketServer::createListenSocket() {
+    const string& socketAddr = options.socketAddr;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("failed to create domain socket at: ", socketAddr);
+        return -1;
+    }
+
+    sockaddr_un server;
+
+    memset(&server, 0, sizeof(server));
+    server.sun_family = AF_UNIX;
+    if (socketAddr.length() >= sizeof(server.sun_path)) {
+        LOG_ERROR("domain socket path too long: ", socketAddr);
+        close(fd);
+        return -1;
+    }
+    strcpy(server.sun_path, socketAddr.c_str());
+    unlink(socketAddr.c_str());
+
+    int size = offsetof(sockaddr_un, sun_path) + socketAddr.length();
+
+    if ( bind(fd, (sockaddr*) &server, size) < 0 ) {
+        LOG_ERROR("failed to bind domain socket: ", socketAddr);
+        close(fd);
+        return -1;
+    }
+
+    if ( listen(fd, options.listenBacklog) < 0 ) {
+        LOG_ERROR("failed to listen domain socket: ", socketAddr);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+void SocketServer::prepare(const Options& options) {
+    this->options = options;
+
+    // zygote 需要在打开其他描述符、启动其他线程前 fork 出来。
+    launcher.init(options.spawnStrategy, options.zygote);
+}
+
+
+int SocketServer::run() {
+    if (loop.init()) {
+        return -1;
+    }
+
+    // 一次性运行时不接管孤儿进程，它们不会被当作启动的程序。
+    if (supervisor.init(loop, [this] (const ChildSupervisor::ExitInfo& info) {
+        onChildExit(info);
+    }, options.keepAlive)) {
+        return -1;
+    }
+
+    auto onIdle = [this] () {
+        if (stopWhenIdle) {
+            loop.stop();
+        }
+    };
+    if (output.init(loop, [this] (Connection* conn) { onOutputForwarded(conn); }, onIdle)) {
+        return -1;
+    }
+
+    if (trace::enabled()) {
+        initTraceSignal();
+    }
+
+    if (!options.recordFile.empty() && recorder.open(options.recordFile)) {
+        LOG_WARN("frames will not be recorded.");
+    }
+
+    if (!options.logCaptureDir.empty()
+        && output.enableLogCapture(
+            options.logCaptureDir, options.logCapture, options.logCaptureSessions
+        )
+    ) {
+        LOG_WARN("failed to enable log capture. child output will not be saved.");
+    }
+
+    launcher.setSpawnCallback([this] (pid_t pid, int pidfd, string_view cmd) {
+        if (firstLaunched.pid == 0) {
+            firstLaunched.pid = pid;
+        }
+        supervisor.track(pid, pidfd, cmd);
+    });
+
+    // 先填满预热池，再开始接受连接。
+    auto& pool = launcher.prewarmPool();
+    if (launcher.initPrewarm(options.prewarm)) {
+        LOG_WARN("failed to start prewarm pool. launching directly.");
+    } else if (pool.timerFd() >= 0) {
+        loop.add(pool.timerFd(), EPOLLIN, [&pool] (uint32_t) {
+            pool.onTimer();
+        });
+    }
+
+    listenFd = createListenSocket();
+    if (listenFd < 0) {
+        return -1;
+    }
+
+    if (options.ioBackend == "io-uring") {
+        backend = make_unique<IoUringBackend>(*this, loop);
+        if (backend->start(listenFd)) {
+            LOG_WARN("failed to start io_uring backend. falling back to epoll.");
+            backend = nullptr;
+        }
+    } else if (options.ioBackend != "epoll") {
+        LOG_WARN("unknown io backend: ", options.ioBackend, ". using epoll.");
+    }
+
+    if (backend == nullptr) {
+        backend = make_unique<EpollBackend>(*this, loop);
+        if (backend->start(listenFd)) {
+            backend = nullptr;
+            close(listenFd);
+            listenFd = -1;
+            return -1;
+        }
+    }
+
+    LOG_INFO(
+        "serving on ", options.socketAddr, " with ", backend->name(), " backend, ",
+        launcher.strategyName(), " spawn strategy."
+    );
+
+    if (!options.vesperCtrlSock.empty()) {
+        initVesperWatch();
+    }
+
+    int res = loop.run();
+
+    // 后端可能还有指向连接的未完成操作，先于连接释放。
+    backend = nullptr;
+    output.shutdown();
+    connections.clear();
+
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+        unlink(options.socketAddr.c_str());
+    }
+
+    if (vesperWatch.enabled()) {
+        loop.remove(vesperWatch.fd());
+        vesperWatch.shutdown();
+    }
+
+    recorder.close();
+
+    if (traceSignalFd >= 0) {
+        loop.remove(traceSignalFd);
+        close(traceSignalFd);
+        traceSignalFd = -1;
+    }
+
+    if (pool.enabled()) {
+        auto& counters = pool.counters();
+        LOG_INFO(
+            "prewarm pool: ", counters.hits, " hits, ", counters.misses, " misses, ",
+            counters.spawned, " spawned, ", counters.died, " died before claimed."
+        );
+        if (pool.timerFd() >= 0) {
+            loop.remove(pool.timerFd());
+        }
+    }
+
+    // 结束预热实例与 zygote。
+    launcher.shutdown();
+    supervisor.shutdown();
+
+    return res;
+}
+
+
+void SocketServer::stop() {
+    loop.stop();
+}
+
+
+void SocketServer::requestStop() {
+    if (output.idle()) {
+        loop.stop();
+        return;
+    }
+
+    if (stopWhenIdle) {
+        return;
+    }
+
+    stopWhenIdle = true;
+    closeListenSocket();
+    LOG_INFO("waiting for output of launched programs to end before exiting.");
+}
+
+
+void SocketServer::closeListenSocket() {
+    if (listenFd < 0) {
+        return;
+    }
+
+    backend->pauseAccept();
+    close(listenFd);
+    listenFd = -1;
+    unlink(options.socketAddr.c_str());
+}
+
+
+void SocketServer::initVesperWatch() {
+    auto callback = [this] (bool live) { onVesperCtrlChanged(live); };
+    if (vesperWatch.init(options.vesperCtrlSock, callback)) {
+        LOG_WARN("failed to watch vesper control socket. keep serving regardless of it.");
+        return;
+    }
+
+    loop.add(vesperWatch.fd(), EPOLLIN, [this] (uint32_t) {
+        vesperWatch.onReadable();
+    });
+
+    if (vesperWatch.live()) {
+        onVesperCtrlChanged(true);
+    }
+}
+
+
+void SocketServer::onVesperCtrlChanged(bool live) {
+    if (!live) {
+        resumeServing();
+    } else if (options.exitOnVesperCtrl) {
+        LOG_INFO("vesper control is live. exiting.");
+        requestStop();
+    } else {
+        standDown();
+    }
+}
+
+
+void SocketServer::standDown() {
+    if (standingDown) {
+        return;
+    }
+
+    closeListenSocket();
+    standingDown = true;
+
+    LOG_INFO("vesper control is live. stopped serving on ", options.socketAddr);
+}
+
+
+void SocketServer::resumeServing() {
+    if (!standingDown || stopWhenIdle) {
+        return;
+    }
+
+    listenFd = createListenSocket();
+    if (listenFd < 0) {
+        LOG_ERROR("failed to resume serving. still standing down.");
+        return;
+    }
+
+    if (backend->resumeAccept(listenFd)) {
+        LOG_ERROR("failed to resume accepting connections. still standing down.");
+        close(listenFd);
+        listenFd = -1;
+        unlink(options.socketAddr.c_str());
+        return;
+    }
+
+    standingDown = false;
+    LOG_INFO("vesper control exited. serving on ", options.socketAddr, " again.");
+}
+
+
+void SocketServer::initTraceSignal() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+
+    traceSignalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (traceSignalFd < 0) {
+        LOG_WARN("failed to create signalfd for SIGUSR1: ", strerror(errno), ". trace is written at exit only.");
+        return;
+    }
+
+    loop.add(traceSignalFd, EPOLLIN, [this] (uint32_t) {
+        signalfd_siginfo info;
+        while (read(traceSignalFd, &info, sizeof(info)) == sizeof(info)) {}
+        trace::dump();
+    });
+}
+
+
+Connection* SocketServer::addConnection(int fd) {
+    auto conn = make_unique<Connection>(fd);
+    conn->decoder.setMaxFrameSize(options.maxFrameSize);
+    conn->id = ++connectionCount;
+    conn->acceptedAt = monotonicNanos();
+    stats.add(Stats::ACCEPTS);
+    trace::instant("io", "accept");
+    auto* connPtr = conn.get();
+    connections[connPtr] = std::move(conn);
+    return connPtr;
+}
+
+
+void SocketServer::removeConnection(Connection* conn) {
+    bool stopNow = stopRequested && conn == stopConn;
+    output.detach(conn);
+    connections.erase(conn);
+
+    if (stopNow) {
+        requestStop();
+    }
+}
+
+
+/** 订阅者积压的数据超过该值时，丢弃新的事件。 */
+static const size_t SUBSCRIBER_MAX_BACKLOG = 1024 * 1024;
+
+
+void SocketServer::onChildExit(const ChildSupervisor::ExitInfo& info) {
+    // 预热池实例与 zygote 不是用户启动的程序，不推送。
+    if (!info.tracked && launcher.onChildExit(info.pid)) {
+        return;
+    }
+
+    if (info.pid == firstLaunched.pid) {
+        firstLaunched.exited = true;
+        firstLaunched.status = info.status;
+    }
+
+    static protocol::ChildExitEvent event;
+
+    event.pid = info.pid;
+    event.tracked = info.tracked;
+
+    if (WIFEXITED(info.status)) {
+        event.reason = protocol::ChildExitEvent::REASON_EXITED;
+        event.value = WEXITSTATUS(info.status);
+    } else {
+        event.reason = WCOREDUMP(info.status)
+            ? protocol::ChildExitEvent::REASON_DUMPED : protocol::ChildExitEvent::REASON_KILLED;
+        event.value = WTERMSIG(info.status);
+    }
+
+    auto& ru = info.usage;
+    event.userTime = uint64_t(ru.ru_utime.tv_sec) * 1000000 + ru.ru_utime.tv_usec;
+    event.systemTime = uint64_t(ru.ru_stime.tv_sec) * 1000000 + ru.ru_stime.tv_usec;
+    event.maxRss = ru.ru_maxrss;
+    event.minorFaults = ru.ru_minflt;
+    event.majorFaults = ru.ru_majflt;
+    event.voluntarySwitches = ru.ru_nvcsw;
+    event.involuntarySwitches = ru.ru_nivcsw;
+
+    // flush 出错时会释放连接，先收集订阅者，再逐个发送。
+    static vector<Connection*> subscribers;
+    subscribers.clear();
+    for (auto& it : connections) {
+        auto* conn = it.first;
+        if ((conn->subscriptions & protocol::Subscribe::EVENT_CHILD_EXIT) && !conn->closeAfterFlush) {
+            subscribers.push_back(conn);
+        }
+    }
+
+    for (auto* conn : subscribers) {
+        if (conn->out.pendingBytes() > SUBSCRIBER_MAX_BACKLOG) {
+            LOG_WARN_KV("subscriber is too slow. dropped exit event.", "pid", info.pid);
+            continue;
+        }
+
+        conn->send(event);
+        backend->flush(conn);
+    }
+}
+
+
+void SocketServer::onResponseSent(Connection* conn) {
+    if (conn->spawnedAt) {
+        stats.record(Stats::SPAWN_TO_RESPONSE, monotonicNanos() - conn->spawnedAt);
+        conn->spawnedAt = 0;
+    }
+
+    auto& tracing = conn->tracing;
+    if (tracing.respondQueuedAt) {
+        trace::setRequest(tracing.request);
+        trace::complete("io", "send response", tracing.respondQueuedAt, trace::now());
+        trace::setRequest(0);
+        tracing.respondQueuedAt = 0;
+    }
+}
+
+
+void SocketServer::onOutputForwarded(Connection* conn) {
+    // 输出流全部结束后，按普通连接的规则决定是否关闭。
+    if (conn->outputStreams == 0 && !options.keepAlive && !conn->subscriptions) {
+        conn->closeAfterFlush = true;
+    }
+
+    backend->flush(conn);
+}
+
+
+/** 待发送数据超过该值时暂停接收。 */
+static const size_t OUTPUT_HIGH_WATER = 64 * 1024;
+
+
+char* SocketServer::prepareReceive(Connection* conn, size_t& len) {
+    return conn->decoder.prepare(len);
+}
+
+
+void SocketServer::onReceived(Connection* conn, size_t bytes) {
+    if (trace::enabled() && conn->tracing.frameStartedAt == 0) {
+        conn->tracing.frameStartedAt = trace::now();
+    }
+
+    conn->decoder.commit(bytes);
+    processFrames(conn);
+}
+
+
+void SocketServer::onReceiveFailed(Connection* conn, int err) {
+    if (conn->closeAfterFlush) {
+        return;
+    }
+
+    conn->closeAfterFlush = true;
+
+    bool persistent = options.keepAlive || conn->subscriptions || conn->outputStreams;
+    if (err == 0 && persistent && !conn->decoder.midFrame()) {
+        return;  // 在两条指令之间断开，属于正常关闭。
+    }
+
+    if (err == 0) {
+        LOG_ERROR("unexpected EOF from socket.");
+    } else {
+        LOG_ERROR_KV("read error!", "errno", err);
+    }
+
+    if (!conn->decoder.headerReceived()) {
+        const char* err = "failed to read header!";
+        LOG_ERROR(err);
+        stats.add(Stats::HEADER_ERRORS);
+        conn->sendResponse(2, err);
+    } else {
+        const char* err = "failed to read body!";
+        LOG_ERROR(err);
+        stats.add(Stats::BODY_ERRORS);
+        conn->sendResponse(5, err);
+    }
+}
+
+
+bool SocketServer::shouldPauseReceive(const Connection* conn) const {
+    return conn->out.pendingBytes() > OUTPUT_HIGH_WATER;
+}
+
+
+void SocketServer::onOutputDrained(Connection* conn) {
+    output.onDrained(conn);
+}
+
+
+void SocketServer::traceFrameReceived(Connection* conn, uint64_t now) {
+    auto& tracing = conn->tracing;
+    trace::setRequest(requestCount);
+
+    // header 与 body 在同一次接收中到达时，只记录 read header。
+    uint64_t headerAt = tracing.headerReceivedAt ? tracing.headerReceivedAt : now;
+    if (tracing.frameStartedAt) {
+        trace::complete("io", "read header", tracing.frameStartedAt, headerAt);
+    }
+    if (tracing.headerReceivedAt) {
+        trace::complete("io", "read body", headerAt, now);
+    }
+
+    tracing.frameStartedAt = 0;
+    tracing.headerReceivedAt = 0;
+}
+
+
+void SocketServer::processFrames(Connection* conn) {
+    FrameDecoder::Frame frame;
+
+    while (!conn->closeAfterFlush) {
+        auto result = conn->decoder.next(frame);
+
+        if (result == FrameDecoder::NEED_MORE) {
+            if (trace::enabled() && conn->decoder.headerReceived() && !conn->tracing.headerReceivedAt) {
+                conn->tracing.headerReceivedAt = trace::now();
+            }
+            break;
+        } else if (result == FrameDecoder::ERR_MAGIC) {
+            const char* err = "magic mismatched!";
+            LOG_ERROR(err);
+            stats.add(Stats::MAGIC_ERRORS);
+            conn->sendResponse(3, err);
+            conn->closeAfterFlush = true;
+            break;
+        } else if (result == FrameDecoder::ERR_TOO_LARGE) {
+            const char* err = "frame too large!";
+            LOG_ERROR(err, " type: ", frame.type, ", length: ", frame.length);
+            stats.add(Stats::OVERSIZED_FRAMES);
+            conn->sendResponse(8, err);
+            if (!options.keepAlive) {
+                conn->closeAfterFlush = true;
+            }
+            continue;
+        }
+
+        uint64_t now = monotonicNanos();
+        stats.add(Stats::FRAMES);
+        requestCount++;
+
+        if (recorder.enabled()) {
+            recorder.record(conn->id, frame.data, protocol::HEADER_LEN + frame.length);
+        }
+
+        if (trace::enabled()) {
+            traceFrameReceived(conn, now);
+        }
+
+        if (conn->acceptedAt) {
+            stats.record(Stats::ACCEPT_TO_DECODE, now - conn->acceptedAt);
+            conn->acceptedAt = 0;
+        }
+
+        if (!options.keepAlive) {
+            // 每个连接只处理一条指令。
+            conn->closeAfterFlush = true;
+        }
+
+        DispatchContext ctx { *conn, launcher, supervisor, output, stats, now };
+        int res = processFrame(frame, ctx);
+
+        if (trace::enabled()) {
+            auto& tracing = conn->tracing;
+            uint64_t done = trace::now();
+
+            if (conn->hasPendingOutput() && !tracing.respondQueuedAt) {
+                tracing.respondQueuedAt = done;
+                tracing.request = requestCount;
+            }
+
+            // 缓冲中可能已经有下一条报文的开头。
+            if (conn->decoder.midFrame()) {
+                tracing.frameStartedAt = done;
+            }
+
+            trace::setRequest(0);
+        }
+
+        if (res == protocol::DISPATCH_DECODE_FAILED || res == protocol::DISPATCH_UNKNOWN_TYPE) {
+            const char* err = "failed to parse protocol!";
+            LOG_ERROR(err);
+            stats.add(Stats::PARSE_ERRORS);
+            conn->sendResponse(7, err);
+            continue;
+        }
+
+        if (res == 0 && !options.keepAlive) {
+            stopRequested = true;
+            stopConn = conn;
+        }
+    }
+
+    if (recorder.enabled()) {
+        recorder.flush();
+    }
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * domain socket 服务端
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "./EventLoop.h"
+#include "./Connection.h"
+#include "./IoBackend.h"
+#include "./ChildSupervisor.h"
+#include "./OutputForwarder.h"
+#include "./FrameRecorder.h"
+#include "./Stats.h"
+#include "../spawn/Launcher.h"
+#include "../control/VesperWatch.h"
+
+namespace vl {
+namespace server {
+
+class SocketServer {
+public:
+    struct Options {
+        /** domain socket 文件的完整路径。 */
+        std::string socketAddr;
+
+        /** listen() 的 backlog。 */
+        int listenBacklog = 64;
+
+        /** I/O 后端。可选 "epoll" 与 "io-uring"。 */
+        std::string ioBackend = "epoll";
+
+        /**
+         * 连接在处理完一条指令后保持打开，可以连续发送多条指令。
+         * 此模式下，启动程序后服务端不会退出。
+         */
+        bool keepAlive = false;
+
+        /** 单条报文 body 的最大长度。超过此长度的报文会被拒绝。 */
+        size_t maxFrameSize = FrameDecoder::DEFAULT_MAX_FRAME_SIZE;
+
+        /** 子进程创建策略。见 spawn::createSpawner()。 */
+        std::string spawnStrategy = "posix-spawn";
+
+        /** 通过预先 fork 的 zygote 辅助进程创建子进程。 */
+        bool zygote = false;
+
+        /** 预热实例池。cmd 为空时不启用。 */
+        spawn::PrewarmPool::Options prewarm;
+
+        /** 子进程输出的日志目录。为空时不捕获。 */
+        std::string logCaptureDir;
+
+        RotatingLog::Options logCapture;
+
+        /** 日志目录中最多保留多少个子进程的日志。 */
+        int logCaptureSessions = 64;
+
+        /** 收到的报文的录制文件。为空时不录制。见 FrameRecorder。 */
+        std::string recordFile;
+
+        /** 监视的 vesper control socket 的完整路径。为空时不监视。见 control::VesperWatch。 */
+        std::string vesperCtrlSock;
+
+        /**
+         * vesper control 开始运行时退出。
+         * 否则暂停服务（关闭并删除监听 socket），直到 vesper control 退出。
+         */
+        bool exitOnVesperCtrl = false;
+    };
+
+    /**
+     * 保存选项，并 fork 出 zygote 等辅助进程。
+     * 辅助进程应从单线程的进程中 fork，因此需要在启动其他线程（如日志写出线程）之前调用。
+     */
+    void prepare(const Options& options);
+
+    /**
+     * 创建 domain socket 并开始服务，直到 stop() 被调用，
+     * 或某条指令要求结束监听。需要先调用 prepare()。
+     *
+     * @return 异常退出时返回负数，否则返回 0。
+     */
+    int run();
+
+    /**
+     * 请求服务端立即退出。可以在信号处理函数中调用。
+     */
+    void stop();
+
+    /**
+     * 第一个启动的子进程。
+     */
+    struct LaunchedChild {
+        /** 没有启动过子进程时为 0。 */
+        pid_t pid = 0;
+
+        /** 服务期间已被回收。 */
+        bool exited = false;
+
+        /** wait4 得到的原始状态。exited 为 true 时有效。 */
+        int status = 0;
+    };
+
+    /**
+     * run() 返回后，用于等待启动的程序退出。
+     * 服务期间退出的子进程已被回收，不能再 wait()。
+     */
+    const LaunchedChild& firstLaunchedChild() const { return firstLaunched; }
+
+    /* ------------ 供 I/O 后端调用 ------------ */
+
+    Connection* addConnection(int fd);
+
+    /**
+     * 释放连接对象。如果 fd 尚未关闭，一并关闭。
+     */
+    void removeConnection(Connection* conn);
+
+    /**
+     * 获取下一次接收数据应写入的位置与最大长度。
+     */
+    char* prepareReceive(Connection* conn, size_t& len);
+
+    /**
+     * 后端已向 prepareReceive() 给出的位置写入 bytes 字节。
+     */
+    void onReceived(Connection* conn, size_t bytes);
+
+    /**
+     * 对端关闭连接，或读取出错。
+     *
+     * @param err 对端关闭时为 0，否则为 errno。
+     */
+    void onReceiveFailed(Connection* conn, int err);
+
+    /**
+     * 待发送的数据过多，应暂停从该连接读取，直到发送缓冲排空。
+     */
+    bool shouldPauseReceive(const Connection* conn) const;
+
+    /**
+     * 连接的发送队列在积压后已经排空。
+     */
+    void onOutputDrained(Connection* conn);
+
+    /**
+     * 发送队列中的数据已交给内核。
+     */
+    void onSent(Connection* conn) {
+        if (conn->spawnedAt || conn->tracing.respondQueuedAt) {
+            onResponseSent(conn);
+        }
+    }
+
+protected:
+    int createListenSocket();
+    void processFrames(Connection* conn);
+
+    /**
+     * 向订阅者推送子进程退出事件。
+     */
+    void onChildExit(const ChildSupervisor::ExitInfo& info);
+
+    /**
+     * 子进程输出已写入连接的发送队列，或某个输出流已结束。
+     */
+    void onOutputForwarded(Connection* conn);
+
+    void onResponseSent(Connection* conn);
+
+    /**
+     * 停止接受新连接，等子进程的输出流全部结束后退出。
+     * 提前关闭输出管道会让仍在写入的子进程收到 SIGPIPE。
+     */
+    void requestStop();
+
+    /**
+     * 关闭并删除监听 socket。
+     */
+    void closeListenSocket();
+
+    void initVesperWatch();
+    void onVesperCtrlChanged(bool live);
+
+    /**
+     * 停止接受新连接，并删除 domain socket。已有连接与子进程不受影响。
+     */
+    void standDown();
+
+    /**
+     * 重新创建 domain socket，恢复接受连接。
+     */
+    void resumeServing();
+
+    Options options;
+    EventLoop loop;
+    std::unique_ptr<IoBackend> backend;
+    ChildSupervisor supervisor;
+    spawn::Launcher launcher;
+    OutputForwarder output;
+    FrameRecorder recorder;
+    Stats stats;
+    int listenFd = -1;
+
+    LaunchedChild firstLaunched;
+
+    control::VesperWatch vesperWatch;
+
+    /** 因 vesper control 正在运行而暂停了服务。 */
+    bool standingDown = false;
+
+    /** 某条指令要求结束监听。相关应答发送完毕后退出。 */
+    bool stopRequested = false;
+    Connection* stopConn = nullptr;
+
+    /** 已调用 requestStop()，正在等待输出流结束。 */
+    bool stopWhenIdle = false;
+
+    /** 已接受的连接数。用作录制文件中的连接编号。 */
+    uint32_t connectionCount = 0;
+
+    /** 已收到的报文数。用作 trace 中的请求编号。 */
+    uint64_t requestCount = 0;
+
+    /** 收到 SIGUSR1 时写出 trace。未启用 trace 时为 -1。 */
+    int traceSignalFd = -1;
+
+    void initTraceSignal();
+
+    /**
+     * 记录一条报文的接收过程，并把之后的事件关联到该请求。
+     */
+    void traceFrameReceived(Connection* conn, uint64_t now);
+
+    std::unordered_map<Connection*, std::unique_ptr<Connection>> connections;
+};
+
+} // namespace server
+} // namespace vl
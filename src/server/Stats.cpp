@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 运行统计：计数器与延迟直方图
+ * 创建于 2026年10月17日
+ */
+
+#include "./Stats.h"
+
+#include <bit>
+#include <ctime>
+
+using namespace std;
+
+namespace vl {
+namespace server {
+
+/* ------------ Histogram ------------ */
+
+int Histogram::bucketOf(uint64_t value) {
+    if (value < uint64_t(SUB_COUNT)) {
+        return int(value);
+    }
+
+    int exp = 63 - countl_zero(value);
+    int sub = int(value >> (exp - SUB_BITS)) & (SUB_COUNT - 1);
+    return (exp - SUB_BITS + 1) * SUB_COUNT + sub;
+}
+
+
+uint64_t Histogram::lowerBound(int bucket) {
+    if (bucket < SUB_COUNT) {
+        return uint64_t(bucket);
+    }
+
+    int exp = bucket / SUB_COUNT + SUB_BITS - 1;
+    int sub = bucket % SUB_COUNT;
+    return uint64_t(SUB_COUNT + sub) << (exp - SUB_BITS);
+}
+
+
+uint64_t Histogram::upperBound(int bucket) {
+    if (bucket < SUB_COUNT) {
+        return uint64_t(bucket);
+    }
+
+    int exp = bucket / SUB_COUNT + SUB_BITS - 1;
+    return lowerBound(bucket) + (uint64_t(1) << (exp - SUB_BITS)) - 1;
+}
+
+
+void Histogram::record(uint64_t value) {
+    // 只有一个线程写入，读-改-写不需要原子指令。
+    auto& bucket = buckets[bucketOf(value)];
+    bucket.store(bucket.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    total.store(total.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    valueSum.store(valueSum.load(memory_order_relaxed) + value, memory_order_relaxed);
+
+    if (value < minValue.load(memory_order_relaxed)) {
+        minValue.store(value, memory_order_relaxed);
+    }
+    if (value > maxValue.load(memory_order_relaxed)) {
+        maxValue.store(value, memory_order_relaxed);
+    }
+}
+
+
+uint64_t Histogram::percentile(int permille) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+
+    // 第 rank 个样本（从 1 开始）所在的桶。
+    uint64_t rank = (n * uint64_t(permille) + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += bucketCount(i);
+        if (seen >= rank) {
+            return std::min(upperBound(i), max());
+        }
+    }
+
+    return max();
+}
+
+
+/* ------------ Stats ------------ */
+
+const char* Stats::counterName(Counter counter) {
+    static const char* names[] = {
+        "accepts",
+        "frames",
+        "header_errors",
+        "magic_errors",
+        "body_errors",
+        "parse_errors",
+        "oversized_frames",
+        "spawns",
+        "spawn_failures"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == COUNTER_COUNT);
+
+    return names[counter];
+}
+
+
+const char* Stats::latencyName(Latency latency) {
+    static const char* names[] = {
+        "accept_to_decode",
+        "decode_to_spawn",
+        "spawn_to_response"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == LATENCY_COUNT);
+
+    return names[latency];
+}
+
+
+uint64_t monotonicNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+} // namespace server
+} // namespace vl
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 运行统计：计数器与延迟直方图
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace vl {
+namespace server {
+
+/**
+ * CLOCK_MONOTONIC 当前时刻。单位为纳秒。
+ */
+uint64_t monotonicNanos();
+
+
+/**
+ * HDR 风格的对数-线性直方图。
+ *
+ * 小于 SUB_COUNT 的值各占一个桶；更大的值按最高位分段，每段再等分为 SUB_COUNT 个桶，
+ * 相对误差不超过 1 / SUB_COUNT。覆盖全部 uint64_t，不需要预先指定范围。
+ *
+ * 只允许一个线程记录（事件循环），记录时不加锁、不分配内存；其他线程可以随时读取。
+ */
+class Histogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    void record(uint64_t value);
+
+    static int bucketOf(uint64_t value);
+
+    /** 桶中最小的值。 */
+    static uint64_t lowerBound(int bucket);
+
+    /** 桶中最大的值。 */
+    static uint64_t upperBound(int bucket);
+
+    uint64_t bucketCount(int bucket) const {
+        return buckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return valueSum.load(std::memory_order_relaxed); }
+    uint64_t min() const { return minValue.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+
+    /**
+     * 使 permille / 1000 的样本不大于它的最小值，精确到桶。没有样本时返回 0。
+     */
+    uint64_t percentile(int permille) const;
+
+protected:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT] {};
+    std::atomic<uint64_t> total { 0 };
+    std::atomic<uint64_t> valueSum { 0 };
+    std::atomic<uint64_t> minValue { UINT64_MAX };
+    std::atomic<uint64_t> maxValue { 0 };
+};
+
+
+/**
+ * launcher 的运行统计。通过 protocol::StatsQuery 读取。
+ *
+ * 与 Histogram 一样，只允许事件循环线程记录。
+ */
+class Stats {
+public:
+    Stats() : startedAt(monotonicNanos()) {}
+
+    enum Counter {
+        /** 接受的连接。 */
+        ACCEPTS,
+
+        /** 收到的完整报文。 */
+        FRAMES,
+
+        /** 读取 header 时连接断开或出错。应答码 2。 */
+        HEADER_ERRORS,
+
+        /** magic 不匹配。应答码 3。 */
+        MAGIC_ERRORS,
+
+        /** 读取 body 时连接断开或出错。应答码 5。 */
+        BODY_ERRORS,
+
+        /** 报文无法解码或类型未知。应答码 7。 */
+        PARSE_ERRORS,
+
+        /** 报文过长。应答码 8。 */
+        OVERSIZED_FRAMES,
+
+        /** 成功启动的子进程。 */
+        SPAWNS,
+
+        /** 启动失败。 */
+        SPAWN_FAILURES,
+
+        COUNTER_COUNT
+    };
+
+    /* 延迟。单位均为纳秒。 */
+    enum Latency {
+        /** 接受连接，到连接上第一条报文接收完整。 */
+        ACCEPT_TO_DECODE,
+
+        /** 报文接收完整，到子进程创建完毕。批量启动时，每个子进程各记录一次。 */
+        DECODE_TO_SPAWN,
+
+        /** 最后一个子进程创建完毕，到应答交给内核发送。 */
+        SPAWN_TO_RESPONSE,
+
+        LATENCY_COUNT
+    };
+
+    void add(Counter counter, uint64_t n = 1) {
+        auto& it = counters[counter];
+        it.store(it.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void record(Latency latency, uint64_t nanos) {
+        histograms[latency].record(nanos);
+    }
+
+    uint64_t counter(Counter counter) const {
+        return counters[counter].load(std::memory_order_relaxed);
+    }
+
+    const Histogram& histogram(Latency latency) const {
+        return histograms[latency];
+    }
+
+    static const char* counterName(Counter counter);
+    static const char* latencyName(Latency latency);
+
+    /** 创建时刻。见 monotonicNanos()。 */
+    const uint64_t startedAt;
+
+protected:
+    std::atomic<uint64_t> counters[COUNTER_COUNT] {};
+    Histogram histograms[LATENCY_COUNT];
+};
+
+
+} // namespace server
+} // namespace vl
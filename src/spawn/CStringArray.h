@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 以 nullptr 结尾的 C 字符串数组
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 把若干 string_view 拼成以 nullptr 结尾的 C 字符串数组，供 execve 使用。
+ * 内存反复使用，稳定运行时不需要分配。
+ */
+class CStringArray {
+public:
+    template <typename Container>
+    void assign(const Container& items) {
+        storage.clear();
+        offsets.clear();
+        for (std::string_view it : items) {
+            offsets.push_back(storage.size());
+            storage.append(it);
+            storage.push_back('\0');
+        }
+
+        // storage 填充完毕后再取地址，避免扩容导致指针失效。
+        ptrs.clear();
+        for (auto offset : offsets) {
+            ptrs.push_back(storage.data() + offset);
+        }
+        ptrs.push_back(nullptr);
+    }
+
+    void clear() {
+        storage.clear();
+        offsets.clear();
+        ptrs.assign(1, nullptr);
+    }
+
+    char** data() { return ptrs.data(); }
+
+    bool empty() const { return offsets.empty(); }
+
+protected:
+    std::string storage;
+    std::vector<size_t> offsets;
+    std::vector<char*> ptrs;
+};
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 clone 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#include "./CloneSpawner.h"
+
+#include <cerrno>
+#include <csignal>
+
+#include <sched.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifndef CLONE_PIDFD
+    #define CLONE_PIDFD 0x00001000
+#endif
+
+namespace vl {
+namespace spawn {
+
+namespace {
+
+struct ChildArgs {
+    const SpawnRequest* req;
+    int err;
+};
+
+int childMain(void* arg) {
+    auto* args = (ChildArgs*) arg;
+    args->err = execChild(*args->req);
+    _exit(127);
+}
+
+} // anonymous namespace
+
+
+pid_t CloneSpawner::spawn(const SpawnRequest& req, int& pidfd) {
+    pidfd = -1;
+
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+
+    ChildArgs args { &req, 0 };
+
+    // glibc 没有导出 clone3。带 CLONE_VM 的 clone3 需要自行切换栈，这里用 clone 包装函数，
+    // pidfd 同样通过 parent_tid 返回。
+    pid_t pid = clone(
+        childMain, childStack + CHILD_STACK_SIZE,
+        CLONE_VM | CLONE_VFORK | CLONE_PIDFD | SIGCHLD | extraFlags,
+        &args, &pidfd
+    );
+
+    int err = errno;
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+
+    lastChildPid = pid;
+
+    if (pid < 0) {
+        pidfd = -1;
+        return -err;
+    }
+
+    if (args.err) {
+        close(pidfd);
+        pidfd = -1;
+
+        // 带 CLONE_PARENT 时，子进程不属于本进程，由真正的父进程回收。
+        if (!(extraFlags & CLONE_PARENT)) {
+            waitpid(pid, nullptr, 0);
+        }
+        return -args.err;
+    }
+
+    return pid;
+}
+
+} // namespace spawn
+} // namespace vl
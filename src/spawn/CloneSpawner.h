@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 clone 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "./Spawner.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * clone(CLONE_VM | CLONE_VFORK | CLONE_PIDFD) + execve。
+ *
+ * 与 vfork 一样不复制页表，同时直接得到子进程的 pidfd。
+ * 子进程运行在独立的栈上，不会破坏父进程的栈帧。
+ */
+class CloneSpawner : public Spawner {
+public:
+    /**
+     * @param extraFlags 附加的 clone 标志。如 CLONE_PARENT。
+     */
+    explicit CloneSpawner(int extraFlags = 0) : extraFlags(extraFlags) {}
+
+    virtual pid_t spawn(const SpawnRequest& req, int& pidfd) override;
+    virtual const char* name() const override { return "clone"; }
+
+    /**
+     * 最近一次创建的子进程 pid。exec 失败时同样有效：
+     * 带 CLONE_PARENT 时，失败的子进程需要由真正的父进程回收。
+     */
+    pid_t lastChild() const { return lastChildPid; }
+
+protected:
+    int extraFlags;
+    pid_t lastChildPid = -1;
+
+    static const size_t CHILD_STACK_SIZE = 64 * 1024;
+
+    /** 子进程的栈。父进程在子进程 exec 前挂起，因此可以复用。 */
+    alignas(16) char childStack[CHILD_STACK_SIZE];
+};
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 简单命令行解析
+ * 创建于 2026年10月17日
+ */
+
+#include "./CommandLine.h"
+
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 在 shell 中有特殊含义的字符。出现任何一个都交给 /bin/sh。
+ * '=' 可能是变量赋值，'#' 可能是注释，'~' 可能被展开，一并视为特殊字符。
+ */
+static const string_view SHELL_SPECIAL_CHARS = "|&;<>()$`\\\"'*?[]#~=%{}!\n";
+
+/**
+ * shell 保留字与特殊内建命令。作为第一个单词时，PATH 中的同名程序不会被执行。
+ */
+static const string_view SHELL_RESERVED[] = {
+    "if", "then", "else", "elif", "fi", "case", "esac", "for", "while", "until",
+    "do", "done", "in", "function", "select", "time",
+    "break", "continue", "eval", "exec", "exit", "export", "readonly", "return",
+    "set", "shift", "trap", "unset", "cd", "alias", "unalias", "read", "wait",
+    "umask", "ulimit", "command", "type", "hash", "local", "source", ".", ":",
+};
+
+
+bool splitSimpleCommand(string_view cmd, vector<string_view>& argv) {
+    argv.clear();
+
+    if (cmd.find_first_of(SHELL_SPECIAL_CHARS) != string_view::npos) {
+        return false;
+    }
+
+    size_t pos = 0;
+    while (true) {
+        pos = cmd.find_first_not_of(" \t", pos);
+        if (pos == string_view::npos) {
+            break;
+        }
+
+        size_t end = cmd.find_first_of(" \t", pos);
+        if (end == string_view::npos) {
+            end = cmd.length();
+        }
+
+        argv.push_back(cmd.substr(pos, end - pos));
+        pos = end;
+    }
+
+    if (argv.empty()) {
+        return false;
+    }
+
+    for (auto& it : SHELL_RESERVED) {
+        if (argv[0] == it) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static bool isExecutableFile(const string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(path.c_str(), X_OK) == 0;
+}
+
+
+bool findInPath(string_view name, string& path) {
+    if (name.find('/') != string_view::npos) {
+        path.assign(name);
+        return isExecutableFile(path);
+    }
+
+    const char* envPath = getenv("PATH");
+    string_view dirs = envPath ? envPath : "/usr/local/bin:/usr/bin:/bin";
+
+    size_t pos = 0;
+    while (pos <= dirs.length()) {
+        size_t end = dirs.find(':', pos);
+        if (end == string_view::npos) {
+            end = dirs.length();
+        }
+
+        auto dir = dirs.substr(pos, end - pos);
+        if (dir.empty()) {
+            path.assign(".");
+        } else {
+            path.assign(dir);
+        }
+        path.push_back('/');
+        path.append(name);
+
+        if (isExecutableFile(path)) {
+            return true;
+        }
+
+        pos = end + 1;
+    }
+
+    return false;
+}
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 简单命令行解析
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 如果 cmd 只由空白分隔的普通单词组成（不含引号、变量、重定向、通配符等 shell 语法），
+ * 把它拆分为参数列表。此时直接 exec 与交给 /bin/sh 执行的效果相同。
+ *
+ * @param argv 拆分结果。引用 cmd。
+ * @return cmd 可以绕过 shell 时返回 true。
+ */
+bool splitSimpleCommand(std::string_view cmd, std::vector<std::string_view>& argv);
+
+/**
+ * 像 shell 一样在 PATH 中查找可执行文件。name 含有 '/' 时直接使用。
+ *
+ * @param path 找到时写入完整路径。
+ * @return 找到时返回 true。
+ */
+bool findInPath(std::string_view name, std::string& path);
+
+} // namespace spawn
+} // namespace vl
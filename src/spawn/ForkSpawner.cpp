@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 fork 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#include "./ForkSpawner.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace vl {
+namespace spawn {
+
+pid_t ForkSpawner::spawn(const SpawnRequest& req, int& pidfd) {
+    pidfd = -1;
+
+    int errPipe[2];
+    if (pipe2(errPipe, O_CLOEXEC) < 0) {
+        return -errno;
+    }
+
+    // 子进程会把 inheritFd 复制到 fd 3，不能让管道占用它。
+    if (req.inheritFd >= 0 && errPipe[1] <= 3) {
+        int fd = fcntl(errPipe[1], F_DUPFD_CLOEXEC, 4);
+        close(errPipe[1]);
+        if (fd < 0) {
+            int err = errno;
+            close(errPipe[0]);
+            return -err;
+        }
+        errPipe[1] = fd;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) { // new process
+        close(errPipe[0]);
+
+        int err = execChild(req);
+        (void) !write(errPipe[1], &err, sizeof(err));
+        _exit(127);
+    }
+
+    close(errPipe[1]);
+
+    if (pid < 0) {
+        int err = errno;
+        close(errPipe[0]);
+        return -err;
+    }
+
+    // exec 成功时管道被关闭，read 返回 0。
+    int childErr = 0;
+    ssize_t n;
+    do {
+        n = read(errPipe[0], &childErr, sizeof(childErr));
+    } while (n < 0 && errno == EINTR);
+    close(errPipe[0]);
+
+    if (n == sizeof(childErr)) {
+        waitpid(pid, nullptr, 0);
+        return -childErr;
+    }
+
+    return pid;
+}
+
+} // namespace spawn
+} // namespace vl
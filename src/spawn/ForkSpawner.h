@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 fork 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "./Spawner.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * fork + execve。
+ *
+ * fork 需要复制页表，耗时随 launcher 内存增长。保留用于对照与兼容。
+ * exec 失败通过 close-on-exec 管道传回。
+ */
+class ForkSpawner : public Spawner {
+public:
+    virtual pid_t spawn(const SpawnRequest& req, int& pidfd) override;
+    virtual const char* name() const override { return "fork"; }
+};
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 启动器：把启动请求转换为 exec 参数，交给 Spawner
+ * 创建于 2026年10月17日
+ */
+
+#include "./Launcher.h"
+#include "./CommandLine.h"
+#include "./ZygoteSpawner.h"
+#include "../Log.h"
+#include "../Trace.h"
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace vl {
+namespace spawn {
+
+void Launcher::init(const string& strategy, bool zygote) {
+    this->strategy = strategy;
+    spawner = createSpawner(strategy);
+    if (spawner == nullptr) {
+        LOG_WARN("unknown spawn strategy: ", strategy, ". using posix-spawn.");
+        this->strategy = "posix-spawn";
+        spawner = createSpawner(this->strategy);
+    }
+
+    // stub 不创建子进程，zygote 与预热池都没有意义。
+    if (zygote && this->strategy == "stub") {
+        LOG_WARN("zygote is disabled with stub spawn strategy.");
+        zygote = false;
+    }
+
+    if (zygote) {
+        auto zygoteSpawner = make_unique<ZygoteSpawner>(std::move(spawner));
+        // 启动失败时，zygoteSpawner 会直接使用原来的策略。
+        if (zygoteSpawner->start()) {
+            LOG_WARN("failed to start zygote. launching directly.");
+        }
+        spawner = std::move(zygoteSpawner);
+    }
+}
+
+
+int Launcher::initPrewarm(const PrewarmPool::Options& options) {
+    if (options.cmd.empty()) {
+        return 0;
+    }
+
+    if (strategy == "stub") {
+        LOG_WARN("prewarm pool is disabled with stub spawn strategy.");
+        return 0;
+    }
+
+    return pool.init(options, createSpawner(strategy));
+}
+
+
+bool Launcher::onChildExit(pid_t pid) {
+    return pool.onChildExit(pid) || (spawner && spawner->onChildExit(pid));
+}
+
+
+void Launcher::shutdown() {
+    pool.shutdown();
+    spawner = nullptr;
+    controlSpawner = nullptr;
+    onSpawned = nullptr;
+}
+
+
+pid_t Launcher::spawn(const char* cwd, string_view cmd, const LaunchParams& params) {
+    SpawnRequest req;
+    req.path = path.c_str();
+    req.argv = argv.data();
+    req.envp = env.empty() ? environ : env.data();
+    req.cwd = cwd;
+    req.controls = params.controls;
+    req.stdoutFd = params.stdoutFd;
+    req.stderrFd = params.stderrFd;
+
+    Spawner* target = spawner.get();
+    if (!target->supports(req)) {
+        if (controlSpawner == nullptr) {
+            controlSpawner = createSpawner("vfork");
+        }
+        target = controlSpawner.get();
+    }
+
+    int pidfd;
+    pid_t pid;
+    {
+        trace::Span span("spawn", "fork+exec");
+        pid = target->spawn(req, pidfd);
+    }
+    if (pid > 0 && onSpawned) {
+        if (cmd.empty()) {
+            cmdLine.clear();
+            for (char** p = argv.data(); *p; p++) {
+                if (p != argv.data()) {
+                    cmdLine.push_back(' ');
+                }
+                cmdLine.append(*p);
+            }
+            cmd = cmdLine;
+        }
+
+        onSpawned(pid, pidfd, cmd);
+    } else if (pidfd >= 0) {
+        close(pidfd);
+    }
+
+    return pid;
+}
+
+
+pid_t Launcher::launchShell(string_view cmd, const LaunchParams& params) {
+    // 池中的实例已经在运行，无法再施加限制或改变 stdio。
+    if (params.plain() && pool.matches(cmd)) {
+        trace::Span span("spawn", "prewarm claim");
+        pid_t pid = pool.claim();
+        if (pid > 0) {
+            if (onSpawned) {
+                onSpawned(pid, -1, cmd);
+            }
+            return pid;
+        }
+    }
+
+    env.clear();
+
+    if (splitSimpleCommand(cmd, words) && findInPath(words[0], path)) {
+        argv.assign(words);
+        return spawn(nullptr, cmd, params);
+    }
+
+    path = "/bin/sh";
+    const string_view shellArgv[] = { "/bin/sh", "-c", cmd };
+    argv.assign(shellArgv);
+
+    return spawn(nullptr, cmd, params);
+}
+
+
+pid_t Launcher::launchExec(
+    string_view path,
+    const vector<string_view>& argv,
+    const vector<string_view>& env,
+    string_view cwd,
+    const LaunchParams& params
+) {
+    this->path.assign(path);
+    this->cwd.assign(cwd);
+
+    if (argv.empty()) {
+        const string_view defaultArgv[] = { path };
+        this->argv.assign(defaultArgv);
+    } else {
+        this->argv.assign(argv);
+    }
+
+    this->env.assign(env);
+
+    return spawn(cwd.empty() ? nullptr : this->cwd.c_str(), "", params);
+}
+
+} // namespace spawn
+} // namespace vl
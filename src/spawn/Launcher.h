@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 启动器：把启动请求转换为 exec 参数，交给 Spawner
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./Spawner.h"
+#include "./CStringArray.h"
+#include "./PrewarmPool.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 启动请求的可选参数。
+ */
+struct LaunchParams {
+    /** exec 前应用的资源控制。为 nullptr 时不做限制。 */
+    const ResourceControls* controls = nullptr;
+
+    /** 非负时，分别作为子进程的 stdout 与 stderr。否则继承 launcher 的。 */
+    int stdoutFd = -1;
+    int stderrFd = -1;
+
+    /** stdoutFd 与 stderrFd 可以忽略（如只用于日志捕获）。此时仍可认领预热池中的实例。 */
+    bool optionalStdio = false;
+
+    /** 是否可以认领预热池中已经在运行的实例。 */
+    bool plain() const {
+        return controls == nullptr && (optionalStdio || (stdoutFd < 0 && stderrFd < 0));
+    }
+};
+
+
+class Launcher {
+public:
+    /**
+     * 每启动（或从预热池认领）一个子进程时调用。
+     * pidfd 为 -1 表示策略没有提供 pidfd；否则所有权转交给回调。
+     * cmd 为启动命令：ShellLaunch 的 cmd，或以空格连接的 argv。
+     */
+    using SpawnCallback = std::function<void (pid_t pid, int pidfd, std::string_view cmd)>;
+
+    /**
+     * @param strategy 见 createSpawner()。未知时使用 posix-spawn。
+     * @param zygote 是否通过 zygote 辅助进程启动。zygote 无法启动时使用 strategy。
+     *               应在 launcher 分配大块内存、打开 socket 之前调用。
+     */
+    void init(const std::string& strategy, bool zygote);
+
+    /**
+     * 启动预热实例池。options.cmd 为空时不启用。
+     * 池的实例总是直接创建，不经过 zygote。
+     *
+     * @return 成功（或不启用）时返回 0。
+     */
+    int initPrewarm(const PrewarmPool::Options& options);
+
+    PrewarmPool& prewarmPool() { return pool; }
+
+    void setSpawnCallback(SpawnCallback callback) { onSpawned = callback; }
+
+    /**
+     * 子进程已被回收。预热池的实例与 zygote 属于 launcher 自己，由此得知其退出。
+     *
+     * @return pid 属于预热池或 zygote 时返回 true。此时不是用户启动的程序。
+     */
+    bool onChildExit(pid_t pid);
+
+    /**
+     * 结束预热池中的实例与 zygote。之后不能再启动子进程。
+     */
+    void shutdown();
+
+    /**
+     * 执行一条 shell 命令。
+     * 命令与预热的命令相同时，优先认领池中的实例。
+     * 命令不含 shell 语法且程序能在 PATH 中找到时，直接 exec，不启动 /bin/sh。
+     *
+     * @param params 只有 params.plain() 时才会认领预热池中的实例。
+     *
+     * @return 子进程 pid。失败时返回 -errno。
+     */
+    pid_t launchShell(std::string_view cmd, const LaunchParams& params = {});
+
+    /**
+     * 直接 exec 指定程序。
+     *
+     * @param argv 为空时使用 { path }。
+     * @param env 为空时继承 launcher 的环境变量。
+     * @param cwd 为空时继承 launcher 的工作目录。
+     *
+     * @return 子进程 pid。失败时返回 -errno。
+     */
+    pid_t launchExec(
+        std::string_view path,
+        const std::vector<std::string_view>& argv,
+        const std::vector<std::string_view>& env,
+        std::string_view cwd,
+        const LaunchParams& params = {}
+    );
+
+    const char* strategyName() const { return spawner ? spawner->name() : "none"; }
+
+protected:
+    /**
+     * @param cmd 传给 onSpawned 的启动命令。为空时由 argv 拼接。
+     */
+    pid_t spawn(const char* cwd, std::string_view cmd, const LaunchParams& params);
+
+    std::unique_ptr<Spawner> spawner;
+
+    /** spawner 无法处理某些请求（如带 controls）时使用。按需创建。 */
+    std::unique_ptr<Spawner> controlSpawner;
+    std::string strategy;
+    PrewarmPool pool;
+    SpawnCallback onSpawned;
+
+    /* 以下缓冲在每次启动时复用。 */
+
+    std::string path;
+    std::string cwd;
+    CStringArray argv;
+    CStringArray env;
+    std::vector<std::string_view> words;
+    std::string cmdLine;
+};
+
+} // namespace spawn
+} // namespace vl
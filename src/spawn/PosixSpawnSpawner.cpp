@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 posix_spawn 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#include "./PosixSpawnSpawner.h"
+
+#include <cerrno>
+#include <csignal>
+
+#include <spawn.h>
+#include <unistd.h>
+
+namespace vl {
+namespace spawn {
+
+pid_t PosixSpawnSpawner::spawn(const SpawnRequest& req, int& pidfd) {
+    pidfd = -1;
+
+    if (req.controls) {
+        return -ENOTSUP;
+    }
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+
+    // 清空信号掩码，并把全部信号恢复为默认处理。
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigfillset(&mask);
+    posix_spawnattr_setsigdefault(&attr, &mask);
+    short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+    if (req.newProcessGroup) {
+        posix_spawnattr_setpgroup(&attr, 0);
+        flags |= POSIX_SPAWN_SETPGROUP;
+    }
+    posix_spawnattr_setflags(&attr, flags);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (req.stdoutFd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, req.stdoutFd, STDOUT_FILENO);
+    }
+    if (req.stderrFd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, req.stderrFd, STDERR_FILENO);
+    }
+    if (req.inheritFd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, req.inheritFd, 3);
+        posix_spawn_file_actions_addclosefrom_np(&actions, 4);
+    } else {
+        posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+    }
+    if (req.cwd) {
+        posix_spawn_file_actions_addchdir_np(&actions, req.cwd);
+    }
+
+    pid_t pid;
+    int err = posix_spawn(&pid, req.path, &actions, &attr, req.argv, req.envp);
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    if (err) {
+        return -err;
+    }
+
+    return pid;
+}
+
+} // namespace spawn
+} // namespace vl
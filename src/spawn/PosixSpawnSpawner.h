@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 posix_spawn 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "./Spawner.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * posix_spawn。
+ *
+ * glibc 内部使用 clone(CLONE_VM | CLONE_VFORK)，不复制页表，并负责信号处理与 exec 失败的报告。
+ */
+class PosixSpawnSpawner : public Spawner {
+public:
+    virtual pid_t spawn(const SpawnRequest& req, int& pidfd) override;
+    virtual const char* name() const override { return "posix-spawn"; }
+
+    /** posix_spawn 无法设置 rlimit、亲和性等。 */
+    virtual bool supports(const SpawnRequest& req) const override { return req.controls == nullptr; }
+};
+
+} // namespace spawn
+} // namespace vl
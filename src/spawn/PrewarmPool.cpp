@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 预热实例池
+ * 创建于 2026年10月17日
+ */
+
+#include "./PrewarmPool.h"
+#include "./CommandLine.h"
+#include "../Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace vl {
+namespace spawn {
+
+PrewarmPool::~PrewarmPool() {
+    shutdown();
+}
+
+
+int PrewarmPool::init(const Options& options, unique_ptr<Spawner> spawner) {
+    this->options = options;
+
+    vector<string_view> words;
+    if (splitSimpleCommand(options.cmd, words) && findInPath(words[0], path)) {
+        argv.assign(words);
+    } else {
+        path = "/bin/sh";
+        const string_view shellArgv[] = { "/bin/sh", "-c", options.cmd };
+        argv.assign(shellArgv);
+    }
+
+    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer < 0) {
+        LOG_ERROR("failed to create timerfd for prewarm pool: ", strerror(errno));
+        return -1;
+    }
+
+    // park 模式下，实例从环境变量得知需要等待 fd 3。
+    if (options.mode == Mode::PARK) {
+        vector<string_view> vars;
+        for (char** p = environ; *p; p++) {
+            if (strncmp(*p, "VESPER_LAUNCHER_PARK_FD=", 24)) {
+                vars.push_back(*p);
+            }
+        }
+        vars.push_back("VESPER_LAUNCHER_PARK_FD=3");
+        env.assign(vars);
+    }
+
+    this->spawner = std::move(spawner);
+
+    fill();
+
+    return 0;
+}
+
+
+int PrewarmPool::spawnOne() {
+    SpawnRequest req;
+    req.path = path.c_str();
+    req.argv = argv.data();
+    req.envp = options.mode == Mode::PARK ? env.data() : environ;
+
+    // 暂停的实例单独成组。launcher 意外退出后，该进程组成为孤儿进程组，
+    // 内核会向其中暂停的进程发送 SIGHUP 与 SIGCONT，实例随之退出，不会永久残留。
+    req.newProcessGroup = options.mode == Mode::STOP;
+
+    // park 模式使用 socketpair 而不是管道，以便唤醒时用 MSG_NOSIGNAL 避免 SIGPIPE。
+    int parkSock[2] = { -1, -1 };
+    if (options.mode == Mode::PARK) {
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, parkSock) < 0) {
+            return -errno;
+        }
+
+        // 读端需要在子进程中变为 fd 3，先移到 3 以上。
+        int fd = fcntl(parkSock[0], F_DUPFD_CLOEXEC, 4);
+        close(parkSock[0]);
+        if (fd < 0) {
+            int err = errno;
+            close(parkSock[1]);
+            return -err;
+        }
+
+        parkSock[0] = fd;
+        req.inheritFd = fd;
+    }
+
+    int pidfd;
+    pid_t pid = spawner->spawn(req, pidfd);
+    if (pidfd >= 0) {
+        close(pidfd);
+    }
+
+    if (parkSock[0] >= 0) {
+        close(parkSock[0]);
+    }
+
+    if (pid < 0) {
+        if (parkSock[1] >= 0) {
+            close(parkSock[1]);
+        }
+        return pid;
+    }
+
+    if (options.mode == Mode::STOP) {
+        kill(pid, SIGSTOP);
+    }
+
+    instances.push_back({ pid, parkSock[1] });
+    stats.spawned++;
+
+    return 0;
+}
+
+
+void PrewarmPool::fill() {
+    while (instances.size() < size_t(options.size)) {
+        int res = spawnOne();
+        if (res < 0) {
+            LOG_ERROR("failed to prewarm: ", options.cmd, ". ", strerror(-res));
+            break;
+        }
+    }
+}
+
+
+/** 实例在等待中退出后，至少隔这么久再补充，避免启动即退出的命令被反复创建。 */
+static const int DIED_REFILL_DELAY_MS = 1000;
+
+
+void PrewarmPool::scheduleRefill(int delayMs) {
+    if (options.refillDelayMs < 0 || timer < 0) {
+        return;
+    }
+
+    if (delayMs < 0) {
+        delayMs = options.refillDelayMs;
+    }
+
+    // it_value 为 0 会解除定时器。立即补充时用 1ns 代替。
+    itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = delayMs / 1000;
+    spec.it_value.tv_nsec = (delayMs % 1000) * 1000000L;
+    if (delayMs == 0) {
+        spec.it_value.tv_nsec = 1;
+    }
+
+    timerfd_settime(timer, 0, &spec, nullptr);
+}
+
+
+void PrewarmPool::onTimer() {
+    uint64_t expirations;
+    (void) !read(timer, &expirations, sizeof(expirations));
+
+    fill();
+}
+
+
+bool PrewarmPool::onChildExit(pid_t pid) {
+    for (auto it = instances.begin(); it != instances.end(); ++it) {
+        if (it->pid != pid) {
+            continue;
+        }
+
+        if (it->parkFd >= 0) {
+            close(it->parkFd);
+        }
+        instances.erase(it);
+
+        stats.died++;
+        LOG_WARN_KV("prewarmed instance exited before claimed. refilling.", "pid", pid);
+        scheduleRefill(max(options.refillDelayMs, DIED_REFILL_DELAY_MS));
+        return true;
+    }
+
+    return false;
+}
+
+
+pid_t PrewarmPool::claim() {
+    while (!instances.empty()) {
+        auto instance = instances.front();
+        instances.pop_front();
+
+        // 实例是 launcher 的子进程。已退出的实例在这里被回收。
+        if (waitpid(instance.pid, nullptr, WNOHANG) != 0) {
+            stats.died++;
+            if (instance.parkFd >= 0) {
+                close(instance.parkFd);
+            }
+            continue;
+        }
+
+        bool woken;
+        if (options.mode == Mode::STOP) {
+            woken = kill(instance.pid, SIGCONT) == 0;
+        } else {
+            char go = 1;
+            woken = send(instance.parkFd, &go, 1, MSG_NOSIGNAL) == 1;
+            close(instance.parkFd);
+            instance.parkFd = -1;
+        }
+
+        if (!woken) {
+            stats.died++;
+            discard(instance);
+            continue;
+        }
+
+        stats.hits++;
+        scheduleRefill();
+        return instance.pid;
+    }
+
+    stats.misses++;
+    scheduleRefill();
+    return -1;
+}
+
+
+void PrewarmPool::discard(const Instance& instance) {
+    kill(instance.pid, SIGKILL);
+    waitpid(instance.pid, nullptr, 0);
+
+    if (instance.parkFd >= 0) {
+        close(instance.parkFd);
+    }
+}
+
+
+void PrewarmPool::shutdown() {
+    for (auto& it : instances) {
+        discard(it);
+    }
+    instances.clear();
+
+    if (timer >= 0) {
+        close(timer);
+        timer = -1;
+    }
+}
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 预热实例池
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./Spawner.h"
+#include "./CStringArray.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 预先启动若干个目标程序的实例。收到相同的启动命令时，直接唤醒一个已加载好的实例，
+ * 不再创建新进程。
+ *
+ * 实例有两种等待方式：
+ * - stop：exec 完成后立即 SIGSTOP，认领时 SIGCONT。对目标程序没有要求。实例位于单独的进程组；
+ * - park：目标程序自行完成初始化后，阻塞读取 fd 3（环境变量 VESPER_LAUNCHER_PARK_FD）。
+ *         认领时 launcher 写入 1 字节并关闭该 socket；读到 EOF 表示 launcher 已放弃该实例，程序应退出。
+ *
+ * 认领后，或实例在等待中退出后，池按 refillDelayMs 补充实例。
+ * 补充由 timerFd() 驱动，调用者需要在其可读时调用 onTimer()。
+ * 实例的退出由调用者回收子进程时通过 onChildExit() 告知。
+ */
+class PrewarmPool {
+public:
+    enum class Mode {
+        STOP,
+        PARK
+    };
+
+    struct Options {
+        /** 预热的命令。格式同 ShellLaunch。为空时不启用。 */
+        std::string cmd;
+
+        /** 保持的实例数。 */
+        int size = 1;
+
+        /** 认领后多久补充实例。0 表示立即，负数表示不补充。 */
+        int refillDelayMs = 0;
+
+        Mode mode = Mode::STOP;
+    };
+
+    struct Counters {
+        /** 启动请求由池中实例满足的次数。 */
+        uint64_t hits = 0;
+
+        /** 启动请求与预热命令相同，但池已空的次数。 */
+        uint64_t misses = 0;
+
+        /** 为池创建的实例数。 */
+        uint64_t spawned = 0;
+
+        /** 在被认领前就已退出的实例数。 */
+        uint64_t died = 0;
+    };
+
+    PrewarmPool() {}
+    ~PrewarmPool();
+
+    PrewarmPool(const PrewarmPool&) = delete;
+    PrewarmPool& operator = (const PrewarmPool&) = delete;
+
+    /**
+     * 启动池，并同步填满。
+     *
+     * @return 成功时返回 0。
+     */
+    int init(const Options& options, std::unique_ptr<Spawner> spawner);
+
+    bool enabled() const { return spawner != nullptr; }
+
+    /**
+     * 启动命令是否与预热的命令相同。
+     */
+    bool matches(std::string_view cmd) const {
+        return enabled() && cmd == options.cmd;
+    }
+
+    /**
+     * 认领一个实例并唤醒它。
+     *
+     * @return 实例 pid。池中没有存活的实例时返回 -1。
+     */
+    pid_t claim();
+
+    /**
+     * 用于驱动补充的定时器。未启用时为 -1。
+     */
+    int timerFd() const { return timer; }
+
+    void onTimer();
+
+    /**
+     * launcher 回收了一个子进程。是池中的实例时，将其移出池，之后不再向该 pid 发送信号；
+     * 同时计入 died 并安排补充，池不会在下一次认领前一直缺员。
+     *
+     * @return pid 是池中的实例时返回 true。
+     */
+    bool onChildExit(pid_t pid);
+
+    /**
+     * 结束所有未被认领的实例。
+     */
+    void shutdown();
+
+    const Counters& counters() const { return stats; }
+
+protected:
+    struct Instance {
+        pid_t pid;
+
+        /** park 模式下，用于唤醒实例的 socket。 */
+        int parkFd;
+    };
+
+    /**
+     * 补充实例直到数量达到 options.size。
+     */
+    void fill();
+
+    int spawnOne();
+
+    /**
+     * @param delayMs 为负时使用 options.refillDelayMs。
+     */
+    void scheduleRefill(int delayMs = -1);
+
+    /**
+     * 杀死并回收实例。
+     */
+    void discard(const Instance& instance);
+
+    Options options;
+    Counters stats;
+
+    std::unique_ptr<Spawner> spawner;
+    std::deque<Instance> instances;
+    int timer = -1;
+
+    /* 预热命令对应的 exec 参数。只需构造一次。 */
+
+    std::string path;
+    CStringArray argv;
+
+    /** park 模式下的环境变量。 */
+    CStringArray env;
+};
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 子进程资源控制
+ * 创建于 2026年10月17日
+ */
+
+#include "./ResourceControls.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+#include <linux/ioprio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+namespace vl {
+namespace spawn {
+
+static int setLimit(int resource, uint64_t value) {
+    rlimit limit { rlim_t(value), rlim_t(value) };
+    return setrlimit(resource, &limit) ? errno : 0;
+}
+
+
+int applyResourceControls(const ResourceControls& c) {
+    int err = 0;
+
+    if ((c.mask & ResourceControls::ADDRESS_SPACE) && (err = setLimit(RLIMIT_AS, c.addressSpace))) {
+        return err;
+    }
+
+    if ((c.mask & ResourceControls::CPU_TIME) && (err = setLimit(RLIMIT_CPU, c.cpuTime))) {
+        return err;
+    }
+
+    if ((c.mask & ResourceControls::OPEN_FILES) && (err = setLimit(RLIMIT_NOFILE, c.openFiles))) {
+        return err;
+    }
+
+    if (c.mask & ResourceControls::AFFINITY) {
+        if (sched_setaffinity(0, sizeof(c.affinity), &c.affinity)) {
+            return errno;
+        }
+    }
+
+    // 先设置调度策略：切换到 SCHED_OTHER 等策略不会改变 nice 值。
+    if (c.mask & ResourceControls::SCHEDULER) {
+        sched_param param {};
+        param.sched_priority = c.schedPriority;
+        if (sched_setscheduler(0, c.schedPolicy, &param)) {
+            return errno;
+        }
+    }
+
+    if (c.mask & ResourceControls::NICE) {
+        if (setpriority(PRIO_PROCESS, 0, c.nice)) {
+            return errno;
+        }
+    }
+
+    if (c.mask & ResourceControls::IO_PRIORITY) {
+        int prio = IOPRIO_PRIO_VALUE(c.ioClass, c.ioLevel);
+        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, prio)) {
+            return errno;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace spawn
+} // namespace vl
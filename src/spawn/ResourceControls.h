@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 子进程资源控制
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <sched.h>
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 在子进程 exec 前应用的资源限制与调度参数。
+ * 只包含定长数据，可以直接按字节复制（如传给 zygote）。
+ */
+struct ResourceControls {
+    enum : uint32_t {
+        ADDRESS_SPACE = 1 << 0,
+        CPU_TIME = 1 << 1,
+        OPEN_FILES = 1 << 2,
+        NICE = 1 << 3,
+        SCHEDULER = 1 << 4,
+        IO_PRIORITY = 1 << 5,
+        AFFINITY = 1 << 6,
+    };
+
+    /** 已设置的项。上述标志的组合。 */
+    uint32_t mask = 0;
+
+    /** RLIMIT_AS。单位为 Byte。 */
+    uint64_t addressSpace = 0;
+
+    /** RLIMIT_CPU。单位为秒。 */
+    uint64_t cpuTime = 0;
+
+    /** RLIMIT_NOFILE。 */
+    uint64_t openFiles = 0;
+
+    int nice = 0;
+
+    int schedPolicy = 0;
+    int schedPriority = 0;
+
+    /** IOPRIO_CLASS_*。 */
+    int ioClass = 0;
+    int ioLevel = 0;
+
+    cpu_set_t affinity;
+
+    bool empty() const { return mask == 0; }
+};
+
+
+/**
+ * 在子进程中应用 controls。
+ * 只使用系统调用，可以在 vfork 的子进程中调用。
+ *
+ * @return 成功时返回 0，否则返回 errno。
+ */
+int applyResourceControls(const ResourceControls& controls);
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#include "./Spawner.h"
+#include "./ForkSpawner.h"
+#include "./PosixSpawnSpawner.h"
+#include "./VforkSpawner.h"
+#include "./CloneSpawner.h"
+#include "./StubSpawner.h"
+
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <linux/close_range.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+namespace vl {
+namespace spawn {
+
+unique_ptr<Spawner> createSpawner(const string& strategy) {
+    if (strategy == "posix-spawn") {
+        return make_unique<PosixSpawnSpawner>();
+    } else if (strategy == "vfork") {
+        return make_unique<VforkSpawner>();
+    } else if (strategy == "clone") {
+        return make_unique<CloneSpawner>();
+    } else if (strategy == "fork") {
+        return make_unique<ForkSpawner>();
+    } else if (strategy == "stub") {
+        return make_unique<StubSpawner>();
+    }
+
+    return nullptr;
+}
+
+
+int execChild(const SpawnRequest& req) {
+
+    // 与父进程共享内存时，父进程的信号处理函数不能在子进程里运行。
+    // 调用者在 spawn 前屏蔽了全部信号，这里先恢复默认处理，再解除屏蔽。
+    struct sigaction sa;
+    for (int sig = 1; sig < NSIG; sig++) {
+        if (sigaction(sig, nullptr, &sa) == 0
+            && sa.sa_handler != SIG_IGN && sa.sa_handler != SIG_DFL
+        ) {
+            sa.sa_handler = SIG_DFL;
+            sa.sa_flags = 0;
+            sigaction(sig, &sa, nullptr);
+        }
+    }
+
+    sigset_t empty;
+    sigemptyset(&empty);
+    sigprocmask(SIG_SETMASK, &empty, nullptr);
+
+    // launcher 自己的描述符都带有 CLOEXEC。这里兜底处理从父进程继承来的其他描述符。
+    // 用 CLOSE_RANGE_CLOEXEC 而不是直接关闭，以免关掉用于报告 exec 失败的管道。
+    syscall(SYS_close_range, 3, ~0U, CLOSE_RANGE_CLOEXEC);
+
+    // dup2 得到的新描述符不带 CLOEXEC。
+    if (req.inheritFd >= 0 && dup2(req.inheritFd, 3) < 0) {
+        return errno;
+    }
+
+    if (req.stdoutFd >= 0 && dup2(req.stdoutFd, STDOUT_FILENO) < 0) {
+        return errno;
+    }
+
+    if (req.stderrFd >= 0 && dup2(req.stderrFd, STDERR_FILENO) < 0) {
+        return errno;
+    }
+
+    if (req.newProcessGroup && setpgid(0, 0) < 0) {
+        return errno;
+    }
+
+    if (req.controls) {
+        int err = applyResourceControls(*req.controls);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (req.cwd && chdir(req.cwd) < 0) {
+        return errno;
+    }
+
+    execve(req.path, req.argv, req.envp);
+    return errno;
+}
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <sys/types.h>
+
+#include "./ResourceControls.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 一次启动所需的全部参数。字符串都以 0 结尾。
+ */
+struct SpawnRequest {
+    /** 可执行文件路径。不会在 PATH 中查找。 */
+    const char* path;
+
+    /** 以 nullptr 结尾。 */
+    char* const* argv;
+
+    /** 以 nullptr 结尾。 */
+    char* const* envp;
+
+    /** 为 nullptr 时继承 launcher 的工作目录。 */
+    const char* cwd = nullptr;
+
+    /** 非负时，该描述符在子进程中以 fd 3 的形式保留。需大于 3。 */
+    int inheritFd = -1;
+
+    /** 非负时，分别作为子进程的 stdout 与 stderr。需大于 3。 */
+    int stdoutFd = -1;
+    int stderrFd = -1;
+
+    /** 子进程是否加入一个以自己为首的新进程组。 */
+    bool newProcessGroup = false;
+
+    /** exec 前应用的资源控制。为 nullptr 时不做限制。 */
+    const ResourceControls* controls = nullptr;
+};
+
+
+/**
+ * 创建子进程并 exec。
+ *
+ * 所有策略都保证：
+ * - 子进程中 fd 0、1、2（以及 inheritFd）以外的描述符在 exec 时关闭；
+ * - 子进程的信号掩码为空，信号处理函数恢复为默认；
+ * - exec 失败（如文件不存在）会在 spawn() 返回前报告给调用者。
+ */
+class Spawner {
+public:
+    virtual ~Spawner() {}
+
+    /**
+     * @param pidfd 策略支持时，写入子进程的 pidfd，由调用者关闭；否则写入 -1。
+     *
+     * @return 成功时返回子进程 pid。失败时返回 -errno。
+     */
+    virtual pid_t spawn(const SpawnRequest& req, int& pidfd) = 0;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * 能否完整处理 req（如 controls）。不能时，调用者应改用其他策略。
+     */
+    virtual bool supports(const SpawnRequest& req) const { return true; }
+
+    /**
+     * launcher 回收了一个子进程。策略自己的辅助进程（如 zygote）退出时，应停止使用该 pid。
+     *
+     * @return pid 属于策略自己时返回 true。
+     */
+    virtual bool onChildExit(pid_t pid) { return false; }
+};
+
+
+/**
+ * 按名称创建策略。可选 "posix-spawn"、"vfork"、"clone"、"fork" 与 "stub"。
+ *
+ * @return 名称未知时返回 nullptr。
+ */
+std::unique_ptr<Spawner> createSpawner(const std::string& strategy);
+
+
+/* ------------ 供各策略在子进程中调用 ------------ */
+
+/**
+ * 在子进程中完成 exec 前的准备，然后 exec。
+ * 子进程可能与父进程共享内存（vfork、CLONE_VM），本函数只使用系统调用，不分配内存。
+ *
+ * @return 只在失败时返回，返回值为 errno。
+ */
+int execChild(const SpawnRequest& req);
+
+} // namespace spawn
+} // namespace vl
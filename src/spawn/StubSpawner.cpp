@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 不创建子进程的占位策略
+ * 创建于 2026年10月17日
+ */
+
+#include "./StubSpawner.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+namespace vl {
+namespace spawn {
+
+pid_t StubSpawner::spawn(const SpawnRequest& req, int& pidfd) {
+    pidfd = -1;
+
+    // 与真实策略一样，对不存在的程序报告 exec 失败。
+    if (access(req.path, X_OK) < 0) {
+        return -errno;
+    }
+
+    pid_t pid = FAKE_PID_BASE + next;
+    next = (next + 1) % FAKE_PID_BASE;
+    return pid;
+}
+
+} // namespace spawn
+} // namespace vl
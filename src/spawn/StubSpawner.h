@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 不创建子进程的占位策略
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "./Spawner.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 只检查 req.path 是否可执行，不创建子进程。用于重放录制的请求、测量 launcher 自身的开销。
+ *
+ * 返回的 pid 从 FAKE_PID_BASE 开始递增。它大于内核允许的最大 pid（PID_MAX_LIMIT），
+ * 不会与真实进程冲突，也不会被登记到 ChildSupervisor。
+ */
+class StubSpawner : public Spawner {
+public:
+    static const pid_t FAKE_PID_BASE = 1 << 30;
+
+    virtual pid_t spawn(const SpawnRequest& req, int& pidfd) override;
+    virtual const char* name() const override { return "stub"; }
+
+protected:
+    pid_t next = 0;
+};
+
+} // namespace spawn
+} // namespace vl
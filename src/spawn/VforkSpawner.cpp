@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 vfork 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#include "./VforkSpawner.h"
+
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace vl {
+namespace spawn {
+
+pid_t VforkSpawner::spawn(const SpawnRequest& req, int& pidfd) {
+    pidfd = -1;
+
+    // 子进程 exec 前屏蔽全部信号，避免父进程的信号处理函数在共享的内存上运行。
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+
+    volatile int childErr = 0;
+
+    pid_t pid = vfork();
+    if (pid == 0) { // new process
+        childErr = execChild(req);
+        _exit(127);
+    }
+
+    int err = errno;
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+
+    if (pid < 0) {
+        return -err;
+    }
+
+    if (childErr) {
+        waitpid(pid, nullptr, 0);
+        return -childErr;
+    }
+
+    return pid;
+}
+
+} // namespace spawn
+} // namespace vl
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 基于 vfork 的子进程创建策略
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include "./Spawner.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * vfork + execve。
+ *
+ * 子进程与父进程共享内存，不复制页表，耗时与 launcher 内存大小无关。
+ * 父进程在子进程 exec 或退出前挂起，子进程直接把 errno 写入共享内存。
+ */
+class VforkSpawner : public Spawner {
+public:
+    virtual pid_t spawn(const SpawnRequest& req, int& pidfd) override;
+    virtual const char* name() const override { return "vfork"; }
+};
+
+} // namespace spawn
+} // namespace vl
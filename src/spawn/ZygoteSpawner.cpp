@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 预先 fork 的 zygote 辅助进程
+ * 创建于 2026年10月17日
+ */
+
+#include "./ZygoteSpawner.h"
+#include "./CloneSpawner.h"
+#include "../Log.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/close_range.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace vl {
+namespace spawn {
+
+ZygoteSpawner::ZygoteSpawner(unique_ptr<Spawner> fallback) {
+    this->fallback = std::move(fallback);
+}
+
+
+ZygoteSpawner::~ZygoteSpawner() {
+    shutdownZygote();
+}
+
+
+int ZygoteSpawner::start() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) {
+        LOG_ERROR("failed to create socketpair for zygote: ", strerror(errno));
+        return -1;
+    }
+
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOG_ERROR("failed to fork zygote: ", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (pid == 0) { // zygote
+        close(fds[0]);
+
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != parent) {
+            _exit(0);
+        }
+        prctl(PR_SET_NAME, "vl-zygote");
+
+        // 把 socket 移到 fd 3，关闭其余描述符。
+        if (fds[1] != 3) {
+            dup3(fds[1], 3, O_CLOEXEC);
+        }
+        syscall(SYS_close_range, 4, ~0U, 0);
+
+        serve(3);
+    }
+
+    close(fds[1]);
+    sock = fds[0];
+    zygotePid = pid;
+    buf.reserve(MAX_MESSAGE);
+
+    return 0;
+}
+
+
+void ZygoteSpawner::shutdownZygote() {
+    if (sock < 0) {
+        return;
+    }
+
+    // zygote 在 socket 关闭后自行退出。已被 launcher 回收时不再等待，该 pid 可能已被复用。
+    close(sock);
+    sock = -1;
+    if (zygotePid > 0) {
+        waitpid(zygotePid, nullptr, 0);
+        zygotePid = -1;
+    }
+}
+
+
+bool ZygoteSpawner::onChildExit(pid_t pid) {
+    if (pid != zygotePid) {
+        return false;
+    }
+
+    // socket 留到下一次启动时发现 zygote 已不在，再改用 fallback。
+    LOG_WARN("zygote exited unexpectedly.");
+    zygotePid = -1;
+    return true;
+}
+
+
+void ZygoteSpawner::serve(int sock) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SIG_DFL;
+    for (int sig = 1; sig < NSIG; sig++) {
+        sigaction(sig, &sa, nullptr);
+    }
+
+    sigset_t empty;
+    sigemptyset(&empty);
+    sigprocmask(SIG_SETMASK, &empty, nullptr);
+
+    CloneSpawner spawner(CLONE_PARENT);
+    vector<char> msg(MAX_MESSAGE);
+    vector<char*> strings;
+
+    while (true) {
+        ssize_t n = recv(sock, msg.data(), msg.size(), MSG_TRUNC);
+        if (n == 0) {
+            _exit(0);
+        } else if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            _exit(1);
+        }
+
+        Reply reply { -1, 0 };
+        int pidfd = -1;
+        RequestHeader header;
+        ResourceControls controls;
+        size_t offset = sizeof(header);
+
+        if (size_t(n) > msg.size() || size_t(n) <= sizeof(header) || msg[n - 1] != '\0') {
+            reply.err = EINVAL;
+        } else {
+            memcpy(&header, msg.data(), sizeof(header));
+
+            if (header.flags & FLAG_HAS_CONTROLS) {
+                // 长度不足时，后面按字符串个数校验会失败。
+                if (size_t(n) > offset + sizeof(controls)) {
+                    memcpy(&controls, msg.data() + offset, sizeof(controls));
+                }
+                offset += sizeof(controls);
+            }
+
+            // 按 0 切分出全部字符串。
+            strings.clear();
+            for (char* p = msg.data() + offset; p < msg.data() + n; p += strlen(p) + 1) {
+                strings.push_back(p);
+            }
+
+            size_t expected = 1 + size_t(header.argc) + header.envc
+                + ((header.flags & FLAG_HAS_CWD) ? 1 : 0);
+
+            if (strings.size() != expected) {
+                reply.err = EINVAL;
+            } else {
+                // 在 strings 中就地插入 argv 与 env 的结尾 nullptr。
+                strings.insert(strings.begin() + 1 + header.argc + header.envc, nullptr);
+                strings.insert(strings.begin() + 1 + header.argc, nullptr);
+
+                SpawnRequest req;
+                req.path = strings[0];
+                req.argv = strings.data() + 1;
+                req.envp = (header.flags & FLAG_INHERIT_ENV)
+                    ? environ : strings.data() + 2 + header.argc;
+                req.cwd = (header.flags & FLAG_HAS_CWD) ? strings.back() : nullptr;
+                req.controls = (header.flags & FLAG_HAS_CONTROLS) ? &controls : nullptr;
+
+                pid_t pid = spawner.spawn(req, pidfd);
+                reply.pid = spawner.lastChild();
+                reply.err = pid < 0 ? -pid : 0;
+            }
+        }
+
+        iovec iov { &reply, sizeof(reply) };
+        msghdr hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_iov = &iov;
+        hdr.msg_iovlen = 1;
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        if (pidfd >= 0) {
+            hdr.msg_control = control;
+            hdr.msg_controllen = sizeof(control);
+            auto* cmsg = CMSG_FIRSTHDR(&hdr);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &pidfd, sizeof(int));
+        }
+
+        ssize_t sent;
+        do {
+            sent = sendmsg(sock, &hdr, MSG_NOSIGNAL);
+        } while (sent < 0 && errno == EINTR);
+
+        if (pidfd >= 0) {
+            close(pidfd);
+        }
+
+        if (sent < 0) {
+            _exit(1);
+        }
+    }
+}
+
+
+bool ZygoteSpawner::encodeRequest(const SpawnRequest& req) {
+    RequestHeader header { 0, 0, 0 };
+
+    buf.resize(sizeof(header));
+
+    if (req.controls) {
+        auto bytes = reinterpret_cast<const char*>(req.controls);
+        buf.insert(buf.end(), bytes, bytes + sizeof(ResourceControls));
+        header.flags |= FLAG_HAS_CONTROLS;
+    }
+
+    auto append = [this] (const char* s) {
+        buf.insert(buf.end(), s, s + strlen(s) + 1);
+    };
+
+    append(req.path);
+    for (auto p = req.argv; *p; p++) {
+        append(*p);
+        header.argc++;
+    }
+
+    if (req.envp == environ) {
+        header.flags |= FLAG_INHERIT_ENV;
+    } else {
+        for (auto p = req.envp; *p; p++) {
+            append(*p);
+            header.envc++;
+        }
+    }
+
+    if (req.cwd) {
+        append(req.cwd);
+        header.flags |= FLAG_HAS_CWD;
+    }
+
+    memcpy(buf.data(), &header, sizeof(header));
+
+    return buf.size() <= MAX_MESSAGE;
+}
+
+
+pid_t ZygoteSpawner::spawn(const SpawnRequest& req, int& pidfd) {
+    pidfd = -1;
+
+    if (bypassesZygote(req) || !encodeRequest(req)) {
+        return fallback->spawn(req, pidfd);
+    }
+
+    if (send(sock, buf.data(), buf.size(), MSG_NOSIGNAL) < 0) {
+        LOG_WARN("zygote is gone (", strerror(errno), "). using ", fallback->name(), " instead.");
+        shutdownZygote();
+        return fallback->spawn(req, pidfd);
+    }
+
+    Reply reply;
+    iovec iov { &reply, sizeof(reply) };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+
+    msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &hdr, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    if (n != sizeof(reply)) {
+        LOG_WARN("zygote is gone. using ", fallback->name(), " instead.");
+        shutdownZygote();
+        return fallback->spawn(req, pidfd);
+    }
+
+    auto* cmsg = CMSG_FIRSTHDR(&hdr);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        memcpy(&pidfd, CMSG_DATA(cmsg), sizeof(int));
+    }
+
+    if (reply.err) {
+        // 子进程由 launcher 回收。
+        if (reply.pid > 0) {
+            waitpid(reply.pid, nullptr, 0);
+        }
+        if (pidfd >= 0) {
+            close(pidfd);
+            pidfd = -1;
+        }
+        return -reply.err;
+    }
+
+    return reply.pid;
+}
+
+} // namespace spawn
+} // namespace vl
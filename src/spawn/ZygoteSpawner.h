@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 预先 fork 的 zygote 辅助进程
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "./Spawner.h"
+
+namespace vl {
+namespace spawn {
+
+/**
+ * 把启动请求转交给 zygote 辅助进程。
+ *
+ * zygote 在 launcher 启动时 fork 出来，此时 launcher 的内存还很小。它已经恢复了默认的信号处理，
+ * 并关闭了多余的描述符，之后只在 socketpair 上等待请求。
+ *
+ * zygote 使用 clone(CLONE_PARENT | CLONE_PIDFD) 创建子进程，因此子进程的父进程仍然是 launcher。
+ * 子进程的 pid 与 pidfd（通过 SCM_RIGHTS）传回 launcher。
+ *
+ * 请求过大、带有 inheritFd，或 zygote 意外退出时，改用 fallback 直接创建子进程。
+ */
+class ZygoteSpawner : public Spawner {
+public:
+    explicit ZygoteSpawner(std::unique_ptr<Spawner> fallback);
+    ~ZygoteSpawner();
+
+    /**
+     * fork 出 zygote 进程。
+     *
+     * @return 成功时返回 0。
+     */
+    int start();
+
+    virtual pid_t spawn(const SpawnRequest& req, int& pidfd) override;
+    virtual const char* name() const override { return "zygote"; }
+
+    virtual bool supports(const SpawnRequest& req) const override {
+        return !bypassesZygote(req) || fallback->supports(req);
+    }
+
+    virtual bool onChildExit(pid_t pid) override;
+
+protected:
+    /** 单条请求的最大长度。超过时不经过 zygote。 */
+    static const size_t MAX_MESSAGE = 64 * 1024;
+
+    /**
+     * 请求消息头。设置 FLAG_HAS_CONTROLS 时，其后紧跟 ResourceControls；
+     * 再之后依次是 path、argv、env、cwd，均以 0 结尾。
+     */
+    struct RequestHeader {
+        uint32_t argc;
+        uint32_t envc;
+        uint32_t flags;
+    };
+
+    static const uint32_t FLAG_INHERIT_ENV = 1 << 0;
+    static const uint32_t FLAG_HAS_CWD = 1 << 1;
+    static const uint32_t FLAG_HAS_CONTROLS = 1 << 2;
+
+    struct Reply {
+        /** 子进程 pid。exec 失败时也可能有效，需要由 launcher 回收。 */
+        int32_t pid;
+
+        /** 失败时为 errno。 */
+        int32_t err;
+    };
+
+    /**
+     * zygote 进程的主循环。不会返回。
+     */
+    [[noreturn]] static void serve(int sock);
+
+    /**
+     * 把请求编码到 buf。
+     *
+     * @return 请求过大时返回 false。
+     */
+    bool encodeRequest(const SpawnRequest& req);
+
+    void shutdownZygote();
+
+    /**
+     * 描述符需要额外传给 zygote，这种少见的情况直接创建。
+     */
+    bool bypassesZygote(const SpawnRequest& req) const {
+        return sock < 0 || req.inheritFd >= 0 || req.stdoutFd >= 0 || req.stderrFd >= 0;
+    }
+
+    std::unique_ptr<Spawner> fallback;
+
+    int sock = -1;
+    pid_t zygotePid = -1;
+
+    std::vector<char> buf;
+};
+
+} // namespace spawn
+} // namespace vl
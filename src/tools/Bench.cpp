@@ -0,0 +1,585 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * vesper-launcher-bench：对正在运行的 launcher 做端到端压测
+ *
+ * 用法见 README。结果以 JSON 输出，便于在版本之间比较。
+ *
+ * 创建于 2026年10月17日
+ */
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../Protocols.h"
+#include "../server/Stats.h"
+#include "./BufferEncoder.h"
+
+using namespace std;
+using vl::server::Histogram;
+using vl::server::monotonicNanos;
+
+namespace vl {
+namespace bench {
+
+static struct {
+    string socketPath;
+
+    /** 并发连接数。 */
+    int clients = 8;
+
+    /** 每个连接上同时在途的请求数。 */
+    int pipeline = 1;
+
+    /** 请求总数。duration 不为 0 时忽略。 */
+    int64_t requests = 1000;
+
+    /** 持续时长。单位为毫秒。 */
+    int64_t duration = 0;
+
+    /** 每秒发出的请求数。为 0 时不限速：每个连接收到应答后立即发出下一条。 */
+    int64_t rate = 0;
+
+    /** 每条请求使用新的连接。 */
+    bool reconnect = false;
+
+    /** shell、batch、exec、status 或 stats。 */
+    string message = "shell";
+
+    string cmd;
+    int64_t batchSize = 4;
+
+    /** 结果文件。为空时输出到 stdout。 */
+    string output;
+} options;
+
+
+struct Client {
+    int fd = -1;
+
+    /** 在途请求的计时起点。 */
+    deque<uint64_t> inFlight;
+
+    /** 尚未写出的请求数据。 */
+    size_t pendingOut = 0;
+
+    vector<char> in;
+    bool pollingOut = false;
+};
+
+
+static tools::BufferEncoder request;
+static uint32_t responseType;
+
+static vector<Client> clients;
+static int epollFd = -1;
+
+static Histogram latency;
+
+static struct {
+    int64_t issued = 0;
+    int64_t completed = 0;
+    int64_t failed = 0;
+    int64_t connects = 0;
+} counters;
+
+
+/* ------------ 请求 ------------ */
+
+/**
+ * 按 options.message 编码请求，并确定期望的应答类型。
+ *
+ * @return 成功时返回 0。
+ */
+static int buildRequest() {
+    const string& msg = options.message;
+
+    if (msg == "shell") {
+        if (options.cmd.empty()) {
+            options.cmd = "true";
+        }
+        protocol::ShellLaunch launch;
+        launch.cmd = options.cmd;
+        protocol::encode(launch, request);
+        responseType = protocol::Response::typeCode;
+    } else if (msg == "batch") {
+        if (options.cmd.empty()) {
+            options.cmd = "true";
+        }
+        protocol::BatchShellLaunch launch;
+        launch.cmds.assign(options.batchSize, options.cmd);
+        protocol::encode(launch, request);
+        responseType = protocol::BatchLaunchResponse::typeCode;
+    } else if (msg == "exec") {
+        if (options.cmd.empty()) {
+            options.cmd = "/bin/true";
+        }
+        protocol::ExecLaunch launch;
+        launch.path = options.cmd;
+        protocol::encode(launch, request);
+        responseType = protocol::Response::typeCode;
+    } else if (msg == "status") {
+        protocol::encode(protocol::StatusQuery(), request);
+        responseType = protocol::StatusResponse::typeCode;
+    } else if (msg == "stats") {
+        protocol::encode(protocol::StatsQuery(), request);
+        responseType = protocol::StatsResponse::typeCode;
+    } else {
+        fprintf(stderr, "error: --message should be one of shell, batch, exec, status and stats.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* ------------ 连接 ------------ */
+
+static int connectClient(Client& client) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, options.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    // 阻塞连接，避免 listen backlog 满时反复重试。连接后改为非阻塞。
+    if (connect(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &client;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+
+    client.fd = fd;
+    client.in.clear();
+    client.pendingOut = 0;
+    client.pollingOut = false;
+    counters.connects++;
+
+    return 0;
+}
+
+
+static void closeClient(Client& client) {
+    if (client.fd < 0) {
+        return;
+    }
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+    close(client.fd);
+    client.fd = -1;
+
+    // 连接断开时，在途的请求都算失败。
+    counters.failed += client.inFlight.size();
+    counters.completed += client.inFlight.size();
+    client.inFlight.clear();
+}
+
+
+static void setPollingOut(Client& client, bool enable) {
+    if (client.pollingOut == enable) {
+        return;
+    }
+
+    epoll_event ev;
+    ev.events = enable ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    ev.data.ptr = &client;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &ev);
+    client.pollingOut = enable;
+}
+
+
+/**
+ * 写出 client 上尚未发出的请求。所有请求内容相同，只需记录剩余字节数。
+ */
+static void flushClient(Client& client) {
+    size_t len = request.size();
+
+    while (client.pendingOut > 0) {
+        size_t offset = (len - client.pendingOut % len) % len;
+        size_t chunk = min(client.pendingOut, len - offset);
+        ssize_t n = write(client.fd, request.data() + offset, chunk);
+
+        if (n > 0) {
+            client.pendingOut -= n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            setPollingOut(client, true);
+            return;
+        } else {
+            closeClient(client);
+            return;
+        }
+    }
+
+    setPollingOut(client, false);
+}
+
+
+/**
+ * 解析收到的应答，记录延迟。
+ *
+ * @return 对端已关闭或连接出错时返回 true。
+ */
+static bool readClient(Client& client) {
+    char buf[64 * 1024];
+    bool closed = false;
+
+    while (true) {
+        ssize_t n = read(client.fd, buf, sizeof(buf));
+        if (n > 0) {
+            client.in.insert(client.in.end(), buf, buf + n);
+            continue;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            break;
+        }
+
+        // 对端关闭或出错。已收到的应答仍然处理，连接由调用方关闭。
+        closed = true;
+        break;
+    }
+
+    uint64_t now = monotonicNanos();
+    size_t offset = 0;
+
+    while (client.in.size() - offset >= size_t(protocol::HEADER_LEN)) {
+        const char* p = client.in.data() + offset;
+        uint32_t type = protocol::readBE32(p + 4);
+        uint64_t length = protocol::readBE64(p + 8);
+
+        if (client.in.size() - offset - protocol::HEADER_LEN < length) {
+            break;
+        }
+
+        if (!client.inFlight.empty()) {
+            latency.record(now - client.inFlight.front());
+            client.inFlight.pop_front();
+
+            // 各应答的第一个字段都是 code。
+            bool ok = memcmp(p, protocol::MAGIC_STR, 4) == 0 && type == responseType
+                && length >= 4 && protocol::readBE32(p + protocol::HEADER_LEN) == 0;
+            if (!ok) {
+                counters.failed++;
+            }
+            counters.completed++;
+        }
+
+        offset += protocol::HEADER_LEN + length;
+    }
+
+    client.in.erase(client.in.begin(), client.in.begin() + offset);
+
+    return closed;
+}
+
+
+/* ------------ 调度 ------------ */
+
+/**
+ * 第 index 条请求的计划发出时刻。不限速时为 0。
+ */
+static uint64_t scheduledAt(uint64_t start, int64_t index) {
+    if (options.rate == 0) {
+        return 0;
+    }
+
+    return start + uint64_t(index) * 1000000000 / uint64_t(options.rate);
+}
+
+
+static bool issuing(uint64_t start, uint64_t now) {
+    if (options.duration > 0) {
+        return now < start + uint64_t(options.duration) * 1000000;
+    }
+
+    return counters.issued < options.requests;
+}
+
+
+/**
+ * 在空闲的连接上发出到期的请求。
+ *
+ * @return 下一条请求的计划时刻。没有待发请求时返回 0。
+ */
+static uint64_t issueRequests(uint64_t start) {
+    uint64_t now = monotonicNanos();
+
+    for (auto& client : clients) {
+        while (issuing(start, now) && int(client.inFlight.size()) < options.pipeline) {
+            uint64_t due = scheduledAt(start, counters.issued);
+            if (due > now) {
+                return due;
+            }
+
+            if (client.fd < 0 && connectClient(client)) {
+                fprintf(stderr, "error: failed to connect to %s: %s\n", options.socketPath.c_str(), strerror(errno));
+                exit(-1);
+            }
+
+            // 限速时从计划时刻开始计时，避免 coordinated omission：服务端变慢时，延迟不会被低估。
+            client.inFlight.push_back(due ? due : now);
+            client.pendingOut += request.size();
+            counters.issued++;
+
+            flushClient(client);
+            if (options.reconnect) {
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+static void run() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    clients.resize(options.clients);
+
+    uint64_t start = monotonicNanos();
+    epoll_event events[64];
+
+    while (true) {
+        uint64_t nextDue = issueRequests(start);
+
+        uint64_t now = monotonicNanos();
+        if (!issuing(start, now) && counters.completed == counters.issued) {
+            break;
+        }
+
+        int timeout = -1;
+        if (nextDue) {
+            timeout = nextDue > now ? int((nextDue - now + 999999) / 1000000) : 0;
+        } else if (options.duration > 0 && issuing(start, now)) {
+            timeout = 1;
+        }
+
+        int n = epoll_wait(epollFd, events, 64, timeout);
+        for (int i = 0; i < n; i++) {
+            auto& client = *(Client*) events[i].data.ptr;
+            if (client.fd < 0) {
+                continue;
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                flushClient(client);
+            }
+
+            if (client.fd >= 0 && events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                bool closed = readClient(client);
+
+                // 对端已关闭，或应答都已收到。
+                if (closed || (options.reconnect && client.inFlight.empty())) {
+                    closeClient(client);
+                }
+            }
+        }
+    }
+
+    uint64_t elapsed = monotonicNanos() - start;
+
+    for (auto& client : clients) {
+        closeClient(client);
+    }
+    close(epollFd);
+
+    /* 结果 */
+
+    FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = fopen(options.output.c_str(), "w");
+        if (out == nullptr) {
+            fprintf(stderr, "error: failed to open %s: %s\n", options.output.c_str(), strerror(errno));
+            exit(-1);
+        }
+    }
+
+    double seconds = double(elapsed) / 1e9;
+    double throughput = seconds > 0 ? double(counters.completed) / seconds : 0;
+    uint64_t samples = latency.count();
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"message\": \"%s\",\n", options.message.c_str());
+    fprintf(out, "  \"clients\": %d,\n", options.clients);
+    fprintf(out, "  \"pipeline\": %d,\n", options.pipeline);
+    fprintf(out, "  \"rate\": %" PRId64 ",\n", options.rate);
+    fprintf(out, "  \"reconnect\": %s,\n", options.reconnect ? "true" : "false");
+    fprintf(out, "  \"requests\": %" PRId64 ",\n", counters.completed);
+    fprintf(out, "  \"errors\": %" PRId64 ",\n", counters.failed);
+    fprintf(out, "  \"connections\": %" PRId64 ",\n", counters.connects);
+    fprintf(out, "  \"elapsed_s\": %.6f,\n", seconds);
+    fprintf(out, "  \"throughput_rps\": %.1f,\n", throughput);
+    fprintf(out, "  \"latency_us\": {\n");
+    fprintf(out, "    \"min\": %.3f,\n", samples ? latency.min() / 1e3 : 0);
+    fprintf(out, "    \"mean\": %.3f,\n", samples ? double(latency.sum()) / samples / 1e3 : 0);
+    fprintf(out, "    \"p50\": %.3f,\n", latency.percentile(500) / 1e3);
+    fprintf(out, "    \"p90\": %.3f,\n", latency.percentile(900) / 1e3);
+    fprintf(out, "    \"p99\": %.3f,\n", latency.percentile(990) / 1e3);
+    fprintf(out, "    \"p999\": %.3f,\n", latency.percentile(999) / 1e3);
+    fprintf(out, "    \"max\": %.3f\n", latency.max() / 1e3);
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    fprintf(
+        stderr, "%" PRId64 " requests (%" PRId64 " errors) in %.3f s: %.1f req/s, p50 %.1f us, p99 %.1f us, p999 %.1f us\n",
+        counters.completed, counters.failed, seconds, throughput,
+        latency.percentile(500) / 1e3, latency.percentile(990) / 1e3, latency.percentile(999) / 1e3
+    );
+}
+
+
+/* ------------ 命令行 ------------ */
+
+static void usage() {
+    fprintf(
+        stderr,
+        "usage: vesper-launcher-bench --domain-socket <path> [options]\n"
+        "  --domain-socket <path>  launcher socket. relative paths are resolved against $XDG_RUNTIME_DIR\n"
+        "  --clients <n>           concurrent connections (default 8)\n"
+        "  --pipeline <n>          in-flight requests per connection (default 1)\n"
+        "  --requests <n>          total requests (default 1000)\n"
+        "  --duration <ms>         run for a fixed time instead of --requests\n"
+        "  --rate <n>              requests per second across all clients (default 0: unlimited)\n"
+        "  --reconnect             open a new connection for every request\n"
+        "  --message <type>        shell, batch, exec, status or stats (default shell)\n"
+        "  --cmd <cmd>             command to launch (default \"true\"; \"/bin/true\" for exec)\n"
+        "  --batch-size <n>        commands per batch (default 4)\n"
+        "  --output <file>         write the JSON result to file instead of stdout\n"
+        "the launcher should run with --keep-alive.\n"
+    );
+}
+
+
+static int readInt(const char* key, const char* str, int64_t minValue, int64_t maxValue, int64_t& value) {
+    char* end = nullptr;
+    long long res = strtoll(str, &end, 10);
+    if (*str == '\0' || *end != '\0' || res < minValue || res > maxValue) {
+        fprintf(stderr, "error: invalid %s: %s\n", key, str);
+        return -1;
+    }
+
+    value = res;
+    return 0;
+}
+
+
+static int parseArgs(int argc, const char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string key = argv[i];
+
+        if (key == "--help" || key == "--usage") {
+            usage();
+            exit(0);
+        } else if (key == "--reconnect") {
+            options.reconnect = true;
+            continue;
+        }
+
+        if (i + 1 == argc) {
+            fprintf(stderr, "error: no value for key %s\n", key.c_str());
+            return -1;
+        }
+        const char* value = argv[++i];
+
+        int64_t n = 0;
+        int res = 0;
+        if (key == "--domain-socket") {
+            options.socketPath = value;
+        } else if (key == "--clients") {
+            res = readInt(argv[i - 1], value, 1, 4096, n);
+            options.clients = int(n);
+        } else if (key == "--pipeline") {
+            res = readInt(argv[i - 1], value, 1, 1024, n);
+            options.pipeline = int(n);
+        } else if (key == "--requests") {
+            res = readInt(argv[i - 1], value, 1, INT64_MAX, options.requests);
+        } else if (key == "--duration") {
+            res = readInt(argv[i - 1], value, 1, INT64_MAX / 1000000, options.duration);
+        } else if (key == "--rate") {
+            res = readInt(argv[i - 1], value, 0, 1000000000, options.rate);
+        } else if (key == "--message") {
+            options.message = value;
+        } else if (key == "--cmd") {
+            options.cmd = value;
+        } else if (key == "--batch-size") {
+            res = readInt(argv[i - 1], value, 1, 65536, options.batchSize);
+        } else if (key == "--output") {
+            options.output = value;
+        } else {
+            fprintf(stderr, "error: key %s is not defined.\n", key.c_str());
+            return -1;
+        }
+
+        if (res) {
+            return res;
+        }
+    }
+
+    if (options.socketPath.empty()) {
+        fprintf(stderr, "error: --domain-socket is required.\n");
+        return -1;
+    }
+
+    if (options.socketPath[0] != '/') {
+        const char* xdg = getenv("XDG_RUNTIME_DIR");
+        if (xdg == nullptr) {
+            fprintf(stderr, "error: XDG_RUNTIME_DIR required for relative socket path.\n");
+            return -1;
+        }
+        options.socketPath = string(xdg) + "/" + options.socketPath;
+    }
+
+    // 每个连接只发一条请求后即关闭，流水线没有意义。
+    if (options.reconnect) {
+        options.pipeline = 1;
+    }
+
+    return 0;
+}
+
+} // namespace bench
+} // namespace vl
+
+
+int main(int argc, const char* argv[]) {
+    if (vl::bench::parseArgs(argc, argv)) {
+        vl::bench::usage();
+        return -1;
+    }
+
+    if (vl::bench::buildRequest()) {
+        return -1;
+    }
+
+    vl::bench::run();
+
+    return vl::bench::counters.failed ? 1 : 0;
+}
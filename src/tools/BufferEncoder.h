@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 编码到连续缓冲的 Encoder。供工具程序使用
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "../ProtocolCodec.h"
+
+namespace vl {
+namespace tools {
+
+/**
+ * 把报文编码到一块连续内存。reference() 的数据会被拷贝。
+ * clear() 后保留已分配的内存。
+ */
+class BufferEncoder : public protocol::Encoder {
+public:
+    virtual char* reserve(size_t n) override {
+        size_t offset = buf.size();
+        buf.resize(offset + n);
+        return buf.data() + offset;
+    }
+
+    virtual void reference(const char* data, size_t len) override {
+        buf.insert(buf.end(), data, data + len);
+    }
+
+    const char* data() const { return buf.data(); }
+    size_t size() const { return buf.size(); }
+
+    void clear() { buf.clear(); }
+
+protected:
+    std::vector<char> buf;
+};
+
+} // namespace tools
+} // namespace vl
@@ -0,0 +1,319 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 报文编解码的微基准
+ *
+ * 对 CodecSamples.h 中的每条样例报文，分别测量：
+ *   decode       反复解码到同一个实例（launcher 的用法，见 MessagePool）
+ *   decode-fresh 每次解码到新实例
+ *   encode       编码到反复使用的缓冲
+ * 输出每条报文的耗时，以及每条报文的内存分配次数与字节数。
+ *
+ * 创建于 2026年10月17日
+ */
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../Protocols.h"
+#include "../server/Stats.h"
+#include "./BufferEncoder.h"
+#include "./CodecSamples.h"
+
+using namespace std;
+
+
+/* ------------ 内存分配计数 ------------ */
+
+// 只在单线程中使用，不需要原子操作。
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+void* operator new(size_t n) {
+    allocCount++;
+    allocBytes += n;
+
+    if (void* p = malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+
+namespace vl {
+namespace bench {
+
+static struct {
+    /** 每项测量的最短时长。单位为毫秒。 */
+    int64_t minTime = 200;
+
+    /** 只运行名称包含该字符串的样例。 */
+    string filter;
+
+    /** 结果文件。为空时不输出 JSON。 */
+    string output;
+} options;
+
+
+struct Measurement {
+    double nanos = 0;
+    double allocs = 0;
+    double bytes = 0;
+};
+
+
+struct Result {
+    string sample;
+    string message;
+    size_t frameSize;
+    bool valid;
+
+    Measurement decode;
+    Measurement decodeFresh;
+    Measurement encode;
+};
+
+
+/**
+ * 阻止编译器优化掉对 p 指向内存的读写。
+ */
+static inline void doNotOptimize(const void* p) {
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+
+/**
+ * 反复调用 fn，直到总耗时超过 options.minTime。
+ */
+template <typename F>
+static Measurement measure(F&& fn) {
+    uint64_t minNanos = uint64_t(options.minTime) * 1000000;
+    uint64_t iterations = 1;
+
+    // 先运行一次，排除首次分配内存等一次性开销。
+    fn();
+
+    while (true) {
+        uint64_t allocs = allocCount;
+        uint64_t bytes = allocBytes;
+        uint64_t begin = server::monotonicNanos();
+
+        for (uint64_t i = 0; i < iterations; i++) {
+            fn();
+        }
+
+        uint64_t elapsed = server::monotonicNanos() - begin;
+
+        if (elapsed >= minNanos || iterations >= (uint64_t(1) << 40)) {
+            Measurement res;
+            res.nanos = double(elapsed) / iterations;
+            res.allocs = double(allocCount - allocs) / iterations;
+            res.bytes = double(allocBytes - bytes) / iterations;
+            return res;
+        }
+
+        // 按已测得的速度估算所需次数，多留一些余量。
+        uint64_t next = elapsed ? uint64_t(double(iterations) * minNanos / elapsed * 1.2) : iterations * 100;
+        iterations = max(iterations * 2, min(next, iterations * 100));
+    }
+}
+
+
+template <typename M>
+static void run(const tools::CodecSample& sample, Result& res) {
+    const char* body = sample.frame.data() + protocol::HEADER_LEN;
+    size_t len = sample.frame.size() - protocol::HEADER_LEN;
+
+    res.message = M::name;
+
+    M pooled;
+    res.decode = measure([&] {
+        int err = protocol::decodeBody(body, len, pooled);
+        doNotOptimize(&pooled);
+        doNotOptimize(&err);
+    });
+
+    res.decodeFresh = measure([&] {
+        M msg;
+        int err = protocol::decodeBody(body, len, msg);
+        doNotOptimize(&msg);
+        doNotOptimize(&err);
+    });
+
+    if (!sample.valid) {
+        return;
+    }
+
+    M msg;
+    if (protocol::decodeBody(body, len, msg)) {
+        fprintf(stderr, "error: sample %s fails to decode.\n", sample.name.c_str());
+        exit(-1);
+    }
+
+    tools::BufferEncoder encoder;
+    res.encode = measure([&] {
+        encoder.clear();
+        protocol::encode(msg, encoder);
+        doNotOptimize(encoder.data());
+    });
+
+    if (encoder.size() != sample.frame.size() || memcmp(encoder.data(), sample.frame.data(), encoder.size())) {
+        fprintf(stderr, "error: sample %s changes after decode and encode.\n", sample.name.c_str());
+        exit(-1);
+    }
+}
+
+
+static void printRow(FILE* out, const char* name, const Measurement& m, size_t frameSize) {
+    fprintf(
+        out, "  %-13s %12.1f ns %10.1f MiB/s %10.2f allocs %14.1f bytes\n",
+        name, m.nanos, m.nanos > 0 ? frameSize / m.nanos * 1e9 / (1 << 20) : 0, m.allocs, m.bytes
+    );
+}
+
+
+static void printMeasurement(FILE* out, const char* key, const Measurement& m, bool last) {
+    fprintf(
+        out, "      \"%s\": { \"ns\": %.1f, \"allocs\": %.2f, \"bytes\": %.1f }%s\n",
+        key, m.nanos, m.allocs, m.bytes, last ? "" : ","
+    );
+}
+
+
+static int writeJson(const vector<Result>& results) {
+    FILE* out = fopen(options.output.c_str(), "w");
+    if (out == nullptr) {
+        fprintf(stderr, "error: failed to open %s: %s\n", options.output.c_str(), strerror(errno));
+        return -1;
+    }
+
+    fprintf(out, "{\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& r = results[i];
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"sample\": \"%s\",\n", r.sample.c_str());
+        fprintf(out, "      \"message\": \"%s\",\n", r.message.c_str());
+        fprintf(out, "      \"frame_size\": %zu,\n", r.frameSize);
+        fprintf(out, "      \"valid\": %s,\n", r.valid ? "true" : "false");
+        printMeasurement(out, "decode", r.decode, false);
+        printMeasurement(out, "decode_fresh", r.decodeFresh, !r.valid);
+        if (r.valid) {
+            printMeasurement(out, "encode", r.encode, true);
+        }
+        fprintf(out, "    }%s\n", i + 1 == results.size() ? "" : ",");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    return fclose(out) == 0 ? 0 : -1;
+}
+
+
+static int runAll() {
+    vector<Result> results;
+
+    for (auto& sample : tools::codecSamples()) {
+        if (!options.filter.empty() && sample.name.find(options.filter) == string::npos) {
+            continue;
+        }
+
+        Result res;
+        res.sample = sample.name;
+        res.frameSize = sample.frame.size();
+        res.valid = sample.valid;
+
+        uint32_t type = protocol::readBE32(sample.frame.data() + 4);
+        tools::visitMessageType(type, [&] <typename M> (M*) {
+            run<M>(sample, res);
+        });
+
+        printf("%s (%s, %zu bytes%s)\n", res.sample.c_str(), res.message.c_str(), res.frameSize, res.valid ? "" : ", invalid");
+        printRow(stdout, "decode", res.decode, res.frameSize);
+        printRow(stdout, "decode-fresh", res.decodeFresh, res.frameSize);
+        if (res.valid) {
+            printRow(stdout, "encode", res.encode, res.frameSize);
+        }
+        fflush(stdout);
+
+        results.push_back(std::move(res));
+    }
+
+    if (!options.output.empty()) {
+        return writeJson(results);
+    }
+
+    return 0;
+}
+
+
+static void usage() {
+    fprintf(
+        stderr,
+        "usage: vesper-launcher-codec-bench [options]\n"
+        "  --min-time <ms>    minimum time per measurement (default 200)\n"
+        "  --filter <str>     only run samples whose name contains str\n"
+        "  --output <file>    also write the results to file as JSON\n"
+    );
+}
+
+
+static int parseArgs(int argc, const char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string key = argv[i];
+
+        if (key == "--help" || key == "--usage") {
+            usage();
+            exit(0);
+        }
+
+        if (i + 1 == argc) {
+            fprintf(stderr, "error: no value for key %s\n", key.c_str());
+            return -1;
+        }
+        const char* value = argv[++i];
+
+        if (key == "--min-time") {
+            char* end = nullptr;
+            options.minTime = strtoll(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || options.minTime <= 0) {
+                fprintf(stderr, "error: invalid --min-time: %s\n", value);
+                return -1;
+            }
+        } else if (key == "--filter") {
+            options.filter = value;
+        } else if (key == "--output") {
+            options.output = value;
+        } else {
+            fprintf(stderr, "error: key %s is not defined.\n", key.c_str());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace bench
+} // namespace vl
+
+
+int main(int argc, const char* argv[]) {
+    if (vl::bench::parseArgs(argc, argv)) {
+        vl::bench::usage();
+        return -1;
+    }
+
+    return vl::bench::runAll();
+}
@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 报文编解码的 fuzz 入口
+ *
+ * 输入视为一条完整报文：header 中的 type 选择报文类型，header 之后的数据全部作为 body。
+ * 对能解码的输入，检查 编码(解码(x)) 能再次解码，且再次编码的结果不变。
+ *
+ * 提供 libFuzzer 的 LLVMFuzzerTestOneInput。未定义 VL_LIBFUZZER 时另带一个 main，
+ * 可以逐个运行语料文件，或从 stdin 读取一条输入（供 AFL 使用）。
+ *
+ * 创建于 2026年10月17日
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../Protocols.h"
+#include "./BufferEncoder.h"
+#include "./CodecSamples.h"
+
+using namespace std;
+
+namespace vl {
+namespace fuzz {
+
+[[noreturn]] static void fail(const char* messageName, const char* what) {
+    fprintf(stderr, "%s: %s\n", messageName, what);
+    abort();
+}
+
+
+/**
+ * 解码 body，再编码、解码、编码，检查两次编码结果一致。
+ */
+template <typename M>
+static void roundTrip(const char* body, size_t len) {
+    // 与 launcher 一样反复使用同一个实例，容器的容量在输入之间保留。
+    static M msg;
+    static M again;
+    static tools::BufferEncoder first;
+    static tools::BufferEncoder second;
+
+    if (protocol::decodeBody(body, len, msg)) {
+        return;
+    }
+
+    first.clear();
+    protocol::encode(msg, first);
+
+    if (first.size() != protocol::HEADER_LEN + protocol::bodyLength(msg)) {
+        fail(M::name, "encoded size differs from bodyLength()");
+    }
+
+    if (protocol::readBE64(first.data() + 8) != first.size() - protocol::HEADER_LEN) {
+        fail(M::name, "length in header differs from encoded body");
+    }
+
+    if (protocol::decodeBody(first.data() + protocol::HEADER_LEN, first.size() - protocol::HEADER_LEN, again)) {
+        fail(M::name, "re-encoded message fails to decode");
+    }
+
+    second.clear();
+    protocol::encode(again, second);
+
+    if (second.size() != first.size() || memcmp(first.data(), second.data(), first.size()) != 0) {
+        fail(M::name, "re-encoded message differs");
+    }
+}
+
+
+static void runOne(const uint8_t* data, size_t size) {
+    if (size < size_t(protocol::HEADER_LEN)) {
+        return;
+    }
+
+    const char* frame = (const char*) data;
+    uint32_t type = protocol::readBE32(frame + 4);
+
+    // 拷贝到恰好大小的缓冲，使越界读取能被 AddressSanitizer 发现。
+    size_t len = size - protocol::HEADER_LEN;
+    vector<char> body(frame + protocol::HEADER_LEN, frame + size);
+
+    tools::visitMessageType(type, [&] <typename M> (M*) {
+        roundTrip<M>(body.data(), len);
+    });
+}
+
+} // namespace fuzz
+} // namespace vl
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    vl::fuzz::runOne(data, size);
+    return 0;
+}
+
+
+#ifndef VL_LIBFUZZER
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace vl {
+namespace fuzz {
+
+/** 写入语料目录时跳过超过此长度的样例。fuzzer 通常不会生成这么长的输入。 */
+constexpr size_t SEED_MAX_SIZE = 64 * 1024;
+
+
+static int readFile(const string& path, vector<uint8_t>& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "error: failed to open %s: %s\n", path.c_str(), strerror(errno));
+        return -1;
+    }
+
+    out.clear();
+    uint8_t buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+
+    bool failed = ferror(f);
+    fclose(f);
+    return failed ? -1 : 0;
+}
+
+
+/**
+ * 运行一个文件，或目录下的所有文件（不递归）。
+ *
+ * @return 运行的输入数。出错时返回 -1。
+ */
+static int runPath(const string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) < 0) {
+        fprintf(stderr, "error: %s: %s\n", path.c_str(), strerror(errno));
+        return -1;
+    }
+
+    vector<uint8_t> data;
+
+    if (!S_ISDIR(st.st_mode)) {
+        if (readFile(path, data)) {
+            return -1;
+        }
+        runOne(data.data(), data.size());
+        return 1;
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        fprintf(stderr, "error: failed to open %s: %s\n", path.c_str(), strerror(errno));
+        return -1;
+    }
+
+    int count = 0;
+    while (dirent* ent = readdir(dir)) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+
+        if (readFile(path + "/" + ent->d_name, data)) {
+            closedir(dir);
+            return -1;
+        }
+        runOne(data.data(), data.size());
+        count++;
+    }
+
+    closedir(dir);
+    return count;
+}
+
+
+static int writeSeeds(const string& dirPath) {
+    int count = 0;
+
+    for (auto& sample : tools::codecSamples()) {
+        if (sample.frame.size() > SEED_MAX_SIZE) {
+            continue;
+        }
+
+        string path = dirPath + "/" + sample.name;
+        FILE* f = fopen(path.c_str(), "wb");
+        if (f == nullptr) {
+            fprintf(stderr, "error: failed to open %s: %s\n", path.c_str(), strerror(errno));
+            return -1;
+        }
+
+        fwrite(sample.frame.data(), 1, sample.frame.size(), f);
+        if (fclose(f) != 0) {
+            fprintf(stderr, "error: failed to write %s: %s\n", path.c_str(), strerror(errno));
+            return -1;
+        }
+        count++;
+    }
+
+    fprintf(stderr, "wrote %d seeds to %s\n", count, dirPath.c_str());
+    return 0;
+}
+
+} // namespace fuzz
+} // namespace vl
+
+
+int main(int argc, const char* argv[]) {
+    using namespace vl::fuzz;
+
+    if (argc == 3 && strcmp(argv[1], "--write-seeds") == 0) {
+        return writeSeeds(argv[2]) ? -1 : 0;
+    }
+
+    if (argc >= 2 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "--usage") == 0)) {
+        fprintf(
+            stderr,
+            "usage: vesper-launcher-codec-fuzz [file or directory]...\n"
+            "       vesper-launcher-codec-fuzz --write-seeds <directory>\n"
+            "with no arguments, one input is read from stdin.\n"
+        );
+        return 0;
+    }
+
+    // 无参数：从 stdin 读取一条输入。
+    if (argc == 1) {
+        vector<uint8_t> data;
+        if (readFile("/dev/stdin", data)) {
+            return -1;
+        }
+        runOne(data.data(), data.size());
+        return 0;
+    }
+
+    int total = 0;
+    for (int i = 1; i < argc; i++) {
+        int n = runPath(argv[i]);
+        if (n < 0) {
+            return -1;
+        }
+        total += n;
+    }
+
+    fprintf(stderr, "%d inputs ok\n", total);
+    return 0;
+}
+
+#endif
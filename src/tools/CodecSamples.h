@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * 编解码基准与 fuzz 共用的样例报文
+ * 创建于 2026年10月17日
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../Protocols.h"
+#include "./BufferEncoder.h"
+
+namespace vl {
+namespace tools {
+
+/**
+ * 一条编码好的完整报文（含 header）。
+ */
+struct CodecSample {
+    std::string name;
+    std::vector<char> frame;
+
+    /** 为 false 时，body 是故意构造的非法数据，解码应当失败。 */
+    bool valid = true;
+};
+
+
+/**
+ * 对 type 对应的报文类型 M 调用 f((M*) nullptr)。Requests 与 Responses 都会查找。
+ *
+ * @return 找到对应类型时返回 true。
+ */
+template <typename F>
+inline bool visitMessageType(uint32_t type, F&& f) {
+    auto visit = [&] <typename... Ms> (protocol::MessageList<Ms...>*) {
+        return ((type == Ms::typeCode ? (f((Ms*) nullptr), true) : false) || ...);
+    };
+
+    return visit((protocol::Requests*) nullptr) || visit((protocol::Responses*) nullptr);
+}
+
+
+namespace detail {
+
+template <typename M>
+inline void addSample(std::vector<CodecSample>& out, const char* name, const M& msg) {
+    BufferEncoder encoder;
+    protocol::encode(msg, encoder);
+    out.push_back({ name, std::vector<char>(encoder.data(), encoder.data() + encoder.size()), true });
+}
+
+
+/**
+ * 用 type 与任意 body 拼出报文。
+ */
+inline void addRawSample(std::vector<CodecSample>& out, const char* name, uint32_t type, const std::string& body) {
+    std::vector<char> frame(protocol::HEADER_LEN);
+    memcpy(frame.data(), protocol::MAGIC_STR, 4);
+    protocol::writeBE32(frame.data() + 4, type);
+    protocol::writeBE64(frame.data() + 8, body.size());
+    frame.insert(frame.end(), body.begin(), body.end());
+    out.push_back({ name, std::move(frame), false });
+}
+
+
+inline std::string be32(uint32_t v) {
+    char buf[4];
+    protocol::writeBE32(buf, v);
+    return std::string(buf, 4);
+}
+
+
+inline std::string be64(uint64_t v) {
+    char buf[8];
+    protocol::writeBE64(buf, v);
+    return std::string(buf, 8);
+}
+
+} // namespace detail
+
+
+/**
+ * 生成样例报文。
+ *
+ * 包括日常大小的请求与应答，以及各字段取极端值的报文：超长字节数组、
+ * 大量短元素的列表、伪造的长度与数量、被截断的 body。
+ */
+inline std::vector<CodecSample> codecSamples() {
+    using namespace protocol;
+    using detail::addSample;
+    using detail::addRawSample;
+    using detail::be32;
+    using detail::be64;
+
+    std::vector<CodecSample> res;
+
+    /* 日常大小 */
+
+    {
+        ShellLaunch msg;
+        msg.cmd = "firefox --new-window https://example.com";
+        addSample(res, "shell", msg);
+
+        msg.options = {
+            { LaunchOption::KEY_NICE, 5 },
+            { LaunchOption::KEY_OPEN_FILES, 1024 },
+            { LaunchOption::KEY_CAPTURE_OUTPUT, OutputChunk::STREAM_STDOUT | OutputChunk::STREAM_STDERR }
+        };
+        addSample(res, "shell+options", msg);
+    }
+
+    std::vector<std::string> argv;
+    std::vector<std::string> env;
+    for (int i = 0; i < 8; i++) {
+        argv.push_back("--arg" + std::to_string(i));
+    }
+    for (int i = 0; i < 32; i++) {
+        env.push_back("VESPER_ENV_" + std::to_string(i) + "=/usr/share/vesper/" + std::to_string(i));
+    }
+
+    size_t execIndex = res.size();
+    {
+        ExecLaunch msg;
+        msg.path = "/usr/bin/env";
+        msg.argv.assign(argv.begin(), argv.end());
+        msg.env.assign(env.begin(), env.end());
+        msg.cwd = "/home/vesper";
+        addSample(res, "exec", msg);
+    }
+
+    {
+        BatchShellLaunch msg;
+        msg.cmds.assign(16, "true");
+        addSample(res, "batch16", msg);
+    }
+
+    addSample(res, "subscribe", Subscribe { Subscribe::EVENT_CHILD_EXIT });
+    addSample(res, "status-query", StatusQuery());
+    addSample(res, "response", Response { 0, { "ok", true } });
+
+    {
+        BatchLaunchResponse msg { 0, {} };
+        for (int i = 0; i < 16; i++) {
+            msg.entries.push_back({ 0, 1000 + i });
+        }
+        addSample(res, "batch-response", msg);
+    }
+
+    addSample(res, "child-exit", ChildExitEvent { 1234, ChildExitEvent::REASON_EXITED, 0, 1, 1, 2, 3, 4, 5, 6, 7 });
+
+    {
+        StatusResponse msg { 0, {} };
+        for (int i = 0; i < 64; i++) {
+            msg.entries.push_back({ 1000 + i, 'S', 1, 2, 3, 4, 5, 6, 7, "/usr/bin/vesper-app --flag" });
+        }
+        addSample(res, "status-response64", msg);
+    }
+
+    addSample(res, "output-chunk", OutputChunk { 1234, OutputChunk::STREAM_STDOUT, std::string_view(env[0]) });
+
+    /* 极端但合法 */
+
+    std::string huge(1 << 20, 'x');
+    {
+        ShellLaunch msg;
+        msg.cmd = huge;
+        addSample(res, "shell-1MiB", msg);
+    }
+
+    {
+        BatchShellLaunch msg;
+        msg.cmds.assign(65536, std::string_view());
+        addSample(res, "batch65536-empty", msg);
+    }
+
+    {
+        for (int i = 32; i < 4096; i++) {
+            env.push_back("E" + std::to_string(i) + "=" + std::to_string(i));
+        }
+        ExecLaunch msg;
+        msg.path = "/bin/true";
+        msg.env.assign(env.begin(), env.end());
+        addSample(res, "exec-env4096", msg);
+    }
+
+    {
+        ShellLaunch msg;
+        msg.cmd = "true";
+        msg.options.assign(4096, { LaunchOption::KEY_CPU, 0 });
+        addSample(res, "shell-options4096", msg);
+    }
+
+    /* 非法 */
+
+    // 数量远超 body 能容纳的元素数，应在分配内存前拒绝。
+    addRawSample(res, "bad-batch-count", BatchShellLaunch::typeCode, be32(UINT32_MAX) + be64(0));
+    addRawSample(res, "bad-exec-argv-count", ExecLaunch::typeCode, be64(0) + be32(UINT32_MAX));
+    addRawSample(res, "bad-options-count", ShellLaunch::typeCode, be64(0) + be32(UINT32_MAX) + std::string(12, '\0'));
+
+    // 长度前缀越界。
+    addRawSample(res, "bad-bytes-len", ShellLaunch::typeCode, be64(UINT64_MAX) + "true");
+    addRawSample(res, "bad-bytes-len-wrap", ShellLaunch::typeCode, be64(UINT64_MAX - 7) + "true");
+
+    // 截断。
+    {
+        auto frame = res[execIndex].frame;
+        frame.resize(frame.size() - 1);
+        std::string body(frame.begin() + HEADER_LEN, frame.end());
+        addRawSample(res, "truncated-exec", ExecLaunch::typeCode, body);
+    }
+
+    addRawSample(res, "truncated-subscribe", Subscribe::typeCode, std::string(3, '\0'));
+
+    return res;
+}
+
+} // namespace tools
+} // namespace vl
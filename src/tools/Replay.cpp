@@ -0,0 +1,596 @@
+// SPDX-License-Identifier: MulanPSL-2.0
+
+/*
+ * vesper-launcher-replay：把 --record-frames 录制的报文重新发送给 launcher
+ *
+ * 录制中的每个连接对应重放时的一个连接，连接内的报文按原顺序发送。
+ * 可以按录制时的节奏（或其倍速）发送，也可以尽快发送。
+ *
+ * 创建于 2026年10月17日
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../Protocols.h"
+#include "../server/FrameRecorder.h"
+#include "../server/Stats.h"
+
+using namespace std;
+using vl::server::FrameRecorder;
+using vl::server::Histogram;
+using vl::server::monotonicNanos;
+
+namespace vl {
+namespace replay {
+
+static struct {
+    string socketPath;
+    string input;
+
+    /** 相对录制节奏的倍速。为 0 时尽快发送。 */
+    double speed = 1;
+
+    /** 录制中超过该时长的空闲被压缩为该时长。单位为毫秒。为 0 时不压缩。 */
+    int64_t maxGap = 1000;
+
+    /** 结果文件。为空时输出到 stdout。 */
+    string output;
+} options;
+
+
+struct Record {
+    /** 相对第一条报文的发送时刻。已按 maxGap 压缩，尚未按 speed 缩放。单位为纳秒。 */
+    uint64_t offset;
+
+    /** 所属连接。下标指向 conns。 */
+    size_t conn;
+
+    const char* frame;
+    size_t len;
+};
+
+
+struct ReplayConn {
+    int fd = -1;
+    bool closed = false;
+
+    /** 尚未发出的报文数。 */
+    size_t remaining = 0;
+
+    /** 在途请求的计时起点。 */
+    deque<uint64_t> inFlight;
+
+    /** 尚未写出的数据。 */
+    vector<char> out;
+    size_t outOffset = 0;
+    bool pollingOut = false;
+
+    vector<char> in;
+};
+
+
+static vector<char> capture;
+static vector<Record> records;
+static vector<ReplayConn> conns;
+static int epollFd = -1;
+
+static Histogram latency;
+
+static struct {
+    uint64_t sent = 0;
+    uint64_t replies = 0;
+    uint64_t errorReplies = 0;
+    uint64_t lost = 0;
+    uint64_t events = 0;
+    uint64_t bytes = 0;
+} counters;
+
+
+/* ------------ 读取录制文件 ------------ */
+
+static int readCapture() {
+    FILE* f = fopen(options.input.c_str(), "rb");
+    if (f == nullptr) {
+        fprintf(stderr, "error: failed to open %s: %s\n", options.input.c_str(), strerror(errno));
+        return -1;
+    }
+
+    char buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        capture.insert(capture.end(), buf, buf + n);
+    }
+    bool failed = ferror(f);
+    fclose(f);
+
+    if (failed) {
+        fprintf(stderr, "error: failed to read %s\n", options.input.c_str());
+        return -1;
+    }
+
+    if (capture.size() < FrameRecorder::FILE_MAGIC_LEN
+        || memcmp(capture.data(), FrameRecorder::FILE_MAGIC, FrameRecorder::FILE_MAGIC_LEN) != 0
+    ) {
+        fprintf(stderr, "error: %s is not a frame record file.\n", options.input.c_str());
+        return -1;
+    }
+
+    // (pid << 32 | connection) -> conns 下标。
+    unordered_map<uint64_t, size_t> connIndex;
+
+    size_t pos = FrameRecorder::FILE_MAGIC_LEN;
+    uint64_t lastTime = 0;
+    uint64_t offset = 0;
+    uint64_t maxGap = uint64_t(options.maxGap) * 1000000;
+
+    while (pos < capture.size()) {
+        size_t left = capture.size() - pos;
+        const char* p = capture.data() + pos;
+
+        if (left < FrameRecorder::RECORD_HEADER_LEN + protocol::HEADER_LEN) {
+            fprintf(stderr, "warning: truncated record at offset %zu. ignored.\n", pos);
+            break;
+        }
+
+        uint64_t time = protocol::readBE64(p);
+        uint64_t key = uint64_t(protocol::readBE32(p + 8)) << 32 | protocol::readBE32(p + 12);
+        const char* frame = p + FrameRecorder::RECORD_HEADER_LEN;
+        uint64_t bodyLength = protocol::readBE64(frame + 8);
+
+        if (bodyLength > left - FrameRecorder::RECORD_HEADER_LEN - protocol::HEADER_LEN) {
+            fprintf(stderr, "warning: truncated record at offset %zu. ignored.\n", pos);
+            break;
+        }
+
+        size_t len = protocol::HEADER_LEN + bodyLength;
+
+        if (records.empty()) {
+            lastTime = time;
+        }
+
+        // 多次运行追加到同一文件时，时刻可能回退，也可能有很长的间隔。
+        uint64_t gap = time > lastTime ? time - lastTime : 0;
+        if (maxGap && gap > maxGap) {
+            gap = maxGap;
+        }
+        offset += gap;
+        lastTime = max(lastTime, time);
+
+        auto [it, inserted] = connIndex.try_emplace(key, conns.size());
+        if (inserted) {
+            conns.emplace_back();
+        }
+        conns[it->second].remaining++;
+
+        records.push_back({ offset, it->second, frame, len });
+        pos += FrameRecorder::RECORD_HEADER_LEN + len;
+    }
+
+    if (records.empty()) {
+        fprintf(stderr, "error: no frames in %s\n", options.input.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* ------------ 连接 ------------ */
+
+static int connectConn(ReplayConn& conn) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, options.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    // 阻塞连接，避免 listen backlog 满时反复重试。连接后改为非阻塞。
+    if (connect(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &conn;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+
+    conn.fd = fd;
+    return 0;
+}
+
+
+static void closeConn(ReplayConn& conn) {
+    if (conn.fd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+        close(conn.fd);
+        conn.fd = -1;
+    }
+
+    conn.closed = true;
+
+    // 连接断开时，在途与未发出的报文都算丢失。
+    counters.lost += conn.inFlight.size() + conn.remaining;
+    conn.inFlight.clear();
+    conn.remaining = 0;
+    conn.out.clear();
+    conn.outOffset = 0;
+}
+
+
+/**
+ * 报文都已发出且收到了应答。
+ */
+static bool finished(const ReplayConn& conn) {
+    return conn.remaining == 0 && conn.inFlight.empty() && conn.outOffset == conn.out.size();
+}
+
+
+static void setPollingOut(ReplayConn& conn, bool enable) {
+    if (conn.pollingOut == enable) {
+        return;
+    }
+
+    epoll_event ev;
+    ev.events = enable ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    ev.data.ptr = &conn;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+    conn.pollingOut = enable;
+}
+
+
+static void flushConn(ReplayConn& conn) {
+    while (conn.outOffset < conn.out.size()) {
+        ssize_t n = write(conn.fd, conn.out.data() + conn.outOffset, conn.out.size() - conn.outOffset);
+
+        if (n > 0) {
+            conn.outOffset += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            setPollingOut(conn, true);
+            return;
+        } else {
+            closeConn(conn);
+            return;
+        }
+    }
+
+    conn.out.clear();
+    conn.outOffset = 0;
+    setPollingOut(conn, false);
+}
+
+
+/**
+ * 解析收到的数据。每条请求对应一条应答；ChildExitEvent 与 OutputChunk 是推送的事件。
+ *
+ * @return 对端已关闭或连接出错时返回 true。
+ */
+static bool readConn(ReplayConn& conn) {
+    char buf[64 * 1024];
+    bool closed = false;
+
+    while (true) {
+        ssize_t n = read(conn.fd, buf, sizeof(buf));
+        if (n > 0) {
+            conn.in.insert(conn.in.end(), buf, buf + n);
+            continue;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            break;
+        }
+
+        closed = true;
+        break;
+    }
+
+    uint64_t now = monotonicNanos();
+    size_t offset = 0;
+
+    while (conn.in.size() - offset >= size_t(protocol::HEADER_LEN)) {
+        const char* p = conn.in.data() + offset;
+        uint32_t type = protocol::readBE32(p + 4);
+        uint64_t length = protocol::readBE64(p + 8);
+
+        if (conn.in.size() - offset - protocol::HEADER_LEN < length) {
+            break;
+        }
+
+        if (type == protocol::ChildExitEvent::typeCode || type == protocol::OutputChunk::typeCode) {
+            counters.events++;
+        } else if (!conn.inFlight.empty()) {
+            latency.record(now - conn.inFlight.front());
+            conn.inFlight.pop_front();
+            counters.replies++;
+
+            // 各应答的第一个字段都是 code。
+            if (length < 4 || protocol::readBE32(p + protocol::HEADER_LEN) != 0) {
+                counters.errorReplies++;
+            }
+        }
+
+        offset += protocol::HEADER_LEN + length;
+    }
+
+    conn.in.erase(conn.in.begin(), conn.in.begin() + offset);
+
+    return closed;
+}
+
+
+/* ------------ 重放 ------------ */
+
+static uint64_t scheduledAt(uint64_t start, const Record& record) {
+    if (options.speed == 0) {
+        return 0;
+    }
+
+    return start + uint64_t(double(record.offset) / options.speed);
+}
+
+
+static void run() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+    uint64_t start = monotonicNanos();
+    size_t next = 0;
+    size_t open = 0;
+    epoll_event events[64];
+
+    while (true) {
+        uint64_t now = monotonicNanos();
+        uint64_t nextDue = 0;
+
+        // 发出所有到期的报文。
+        while (next < records.size()) {
+            auto& record = records[next];
+            uint64_t due = scheduledAt(start, record);
+            if (due > now) {
+                nextDue = due;
+                break;
+            }
+
+            next++;
+            auto& conn = conns[record.conn];
+            if (conn.closed) {
+                continue;
+            }
+
+            if (conn.fd < 0) {
+                if (connectConn(conn)) {
+                    fprintf(stderr, "error: failed to connect to %s: %s\n", options.socketPath.c_str(), strerror(errno));
+                    exit(-1);
+                }
+                open++;
+            }
+
+            // 按计划时刻计时，launcher 处理变慢造成的排队也计入延迟。
+            conn.inFlight.push_back(due ? due : now);
+            conn.remaining--;
+            conn.out.insert(conn.out.end(), record.frame, record.frame + record.len);
+            counters.sent++;
+            counters.bytes += record.len;
+
+            flushConn(conn);
+            if (conn.closed) {
+                open--;
+            }
+
+            // 尽快发送时，每批最多发出 64 条报文，再处理应答，避免发送队列无限增长。
+            if (options.speed == 0 && next % 64 == 0) {
+                break;
+            }
+        }
+
+        if (next == records.size() && open == 0) {
+            break;
+        }
+
+        int timeout = -1;
+        if (nextDue) {
+            now = monotonicNanos();
+            timeout = nextDue > now ? int((nextDue - now + 999999) / 1000000) : 0;
+        } else if (next < records.size()) {
+            timeout = 0;
+        }
+
+        int n = epoll_wait(epollFd, events, 64, timeout);
+        for (int i = 0; i < n; i++) {
+            auto& conn = *(ReplayConn*) events[i].data.ptr;
+            if (conn.fd < 0) {
+                continue;
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                flushConn(conn);
+            }
+
+            bool closed = conn.closed;
+            if (!closed && events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                closed = readConn(conn);
+            }
+
+            if (!conn.closed && (closed || finished(conn))) {
+                closeConn(conn);
+            }
+
+            if (conn.closed) {
+                open--;
+            }
+        }
+    }
+
+    uint64_t elapsed = monotonicNanos() - start;
+    close(epollFd);
+
+    /* 结果 */
+
+    FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = fopen(options.output.c_str(), "w");
+        if (out == nullptr) {
+            fprintf(stderr, "error: failed to open %s: %s\n", options.output.c_str(), strerror(errno));
+            exit(-1);
+        }
+    }
+
+    double seconds = double(elapsed) / 1e9;
+    double throughput = seconds > 0 ? double(counters.replies) / seconds : 0;
+    uint64_t samples = latency.count();
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"input\": \"%s\",\n", options.input.c_str());
+    fprintf(out, "  \"speed\": %g,\n", options.speed);
+    fprintf(out, "  \"connections\": %zu,\n", conns.size());
+    fprintf(out, "  \"frames\": %" PRIu64 ",\n", counters.sent);
+    fprintf(out, "  \"bytes\": %" PRIu64 ",\n", counters.bytes);
+    fprintf(out, "  \"replies\": %" PRIu64 ",\n", counters.replies);
+    fprintf(out, "  \"error_replies\": %" PRIu64 ",\n", counters.errorReplies);
+    fprintf(out, "  \"lost\": %" PRIu64 ",\n", counters.lost);
+    fprintf(out, "  \"events\": %" PRIu64 ",\n", counters.events);
+    fprintf(out, "  \"recorded_s\": %.6f,\n", records.back().offset / 1e9);
+    fprintf(out, "  \"elapsed_s\": %.6f,\n", seconds);
+    fprintf(out, "  \"throughput_rps\": %.1f,\n", throughput);
+    fprintf(out, "  \"latency_us\": {\n");
+    fprintf(out, "    \"min\": %.3f,\n", samples ? latency.min() / 1e3 : 0);
+    fprintf(out, "    \"mean\": %.3f,\n", samples ? double(latency.sum()) / samples / 1e3 : 0);
+    fprintf(out, "    \"p50\": %.3f,\n", latency.percentile(500) / 1e3);
+    fprintf(out, "    \"p90\": %.3f,\n", latency.percentile(900) / 1e3);
+    fprintf(out, "    \"p99\": %.3f,\n", latency.percentile(990) / 1e3);
+    fprintf(out, "    \"p999\": %.3f,\n", latency.percentile(999) / 1e3);
+    fprintf(out, "    \"max\": %.3f\n", latency.max() / 1e3);
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    fprintf(
+        stderr,
+        "%" PRIu64 " frames on %zu connections in %.3f s (recorded %.3f s): %.1f req/s, "
+        "%" PRIu64 " error replies, %" PRIu64 " lost, p50 %.1f us, p99 %.1f us\n",
+        counters.sent, conns.size(), seconds, records.back().offset / 1e9, throughput,
+        counters.errorReplies, counters.lost, latency.percentile(500) / 1e3, latency.percentile(990) / 1e3
+    );
+}
+
+
+/* ------------ 命令行 ------------ */
+
+static void usage() {
+    fprintf(
+        stderr,
+        "usage: vesper-launcher-replay --domain-socket <path> --input <file> [options]\n"
+        "  --domain-socket <path>  launcher socket. relative paths are resolved against $XDG_RUNTIME_DIR\n"
+        "  --input <file>          file written by vesper-launcher --record-frames\n"
+        "  --speed <x>             replay at x times the recorded pace (default 1). \"max\": as fast as possible\n"
+        "  --max-gap <ms>          shorten idle periods longer than this (default 1000, 0: keep)\n"
+        "  --output <file>         write the JSON result to file instead of stdout\n"
+        "to replay without launching programs, run the launcher with --spawn-strategy stub.\n"
+    );
+}
+
+
+static int parseArgs(int argc, const char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string key = argv[i];
+
+        if (key == "--help" || key == "--usage") {
+            usage();
+            exit(0);
+        }
+
+        if (i + 1 == argc) {
+            fprintf(stderr, "error: no value for key %s\n", key.c_str());
+            return -1;
+        }
+        const char* value = argv[++i];
+        char* end = nullptr;
+
+        if (key == "--domain-socket") {
+            options.socketPath = value;
+        } else if (key == "--input") {
+            options.input = value;
+        } else if (key == "--speed") {
+            if (strcmp(value, "max") == 0) {
+                options.speed = 0;
+            } else {
+                options.speed = strtod(value, &end);
+                if (*value == '\0' || *end != '\0' || !(options.speed > 0)) {
+                    fprintf(stderr, "error: invalid --speed: %s\n", value);
+                    return -1;
+                }
+            }
+        } else if (key == "--max-gap") {
+            options.maxGap = strtoll(value, &end, 10);
+            if (*value == '\0' || *end != '\0' || options.maxGap < 0 || options.maxGap > INT64_MAX / 1000000) {
+                fprintf(stderr, "error: invalid --max-gap: %s\n", value);
+                return -1;
+            }
+        } else if (key == "--output") {
+            options.output = value;
+        } else {
+            fprintf(stderr, "error: key %s is not defined.\n", key.c_str());
+            return -1;
+        }
+    }
+
+    if (options.socketPath.empty() || options.input.empty()) {
+        fprintf(stderr, "error: --domain-socket and --input are required.\n");
+        return -1;
+    }
+
+    if (options.socketPath[0] != '/') {
+        const char* xdg = getenv("XDG_RUNTIME_DIR");
+        if (xdg == nullptr) {
+            fprintf(stderr, "error: XDG_RUNTIME_DIR required for relative socket path.\n");
+            return -1;
+        }
+        options.socketPath = string(xdg) + "/" + options.socketPath;
+    }
+
+    return 0;
+}
+
+} // namespace replay
+} // namespace vl
+
+
+int main(int argc, const char* argv[]) {
+    if (vl::replay::parseArgs(argc, argv)) {
+        vl::replay::usage();
+        return -1;
+    }
+
+    if (vl::replay::readCapture()) {
+        return -1;
+    }
+
+    vl::replay::run();
+
+    return vl::replay::counters.lost ? 1 : 0;
+}